@@ -0,0 +1,149 @@
+#include "batch.h"
+#include "engine.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void print_batch_usage() {
+    std::fprintf(stderr,
+        "usage: numeric-engine --batch <in.txt|-> [--out <out.txt>] [--full] [--exact] [--digits N] [--prec BITS]\n"
+        "                      [--angle deg|rad|grad] [--time-limit MS] [--memory-limit MB]\n"
+        "                      [--dump-opt] [--trace <trace.json>]\n"
+        "  --full             write every significant digit asked for instead of the 24-character display form\n"
+        "  --exact            write fractions exactly (\"1/3\", \"0.375\") when only + - * / and integer powers are used\n"
+        "  --digits N         significant digits to get right (default 24, or 80 with --full)\n"
+        "  --prec BITS        evaluate at a fixed precision instead of choosing one per line\n"
+        "  --time-limit MS    give up on a line after MS milliseconds (\"Error: time limit\")\n"
+        "  --memory-limit MB  cap the limb storage of one line's values (\"Error: memory limit\")\n"
+        "  --dump-opt         print the optimizer's node counts for each compiled expression to stderr\n"
+        "  --trace FILE       write stage timings as Chrome trace-event JSON (needs NUMERIC_ENGINE_TRACE)\n");
+}
+
+bool is_batch_invocation(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--batch") == 0) return true;
+    return false;
+}
+
+int batch_main(int argc, char* argv[]) {
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+    const char* trace_path = nullptr;
+    bool full = false;
+    EvalOptions opts;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--batch" && i + 1 < argc) in_path = argv[++i];
+        else if (a == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (a == "--full") full = true;
+        else if (a == "--exact") opts.exact = true;
+        else if (a == "--digits" && i + 1 < argc) opts.digits = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--prec" && i + 1 < argc) opts.precision = std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--time-limit" && i + 1 < argc) opts.time_limit_ms = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--memory-limit" && i + 1 < argc) opts.memory_limit = std::strtoul(argv[++i], nullptr, 10) << 20;
+        else if (a == "--dump-opt") opts.dump_optimizer = true;
+        else if (a == "--trace" && i + 1 < argc) trace_path = argv[++i];
+        else if (a == "--angle" && i + 1 < argc) {
+            std::string u = argv[++i];
+            if (u == "deg") opts.angle_unit = ANG_DEG;
+            else if (u == "rad") opts.angle_unit = ANG_RAD;
+            else if (u == "grad") opts.angle_unit = ANG_GRAD;
+            else { print_batch_usage(); return 2; }
+        }
+        else { print_batch_usage(); return 2; }
+    }
+    if (!in_path || opts.digits == 0) { print_batch_usage(); return 2; }
+    if (trace_path && !trace::compiled_in) {
+        std::fprintf(stderr, "error: --trace needs a build configured with -DNUMERIC_ENGINE_TRACE=ON\n");
+        return 2;
+    }
+    if (full && opts.digits < 80) opts.digits = 80;
+
+    // Input is read one line at a time and results are written as they are
+    // produced, so memory use does not depend on the file size.
+    std::ifstream in_file;
+    std::istream* in = &std::cin;
+    if (std::strcmp(in_path, "-") != 0) {
+        in_file.open(in_path, std::ios::in | std::ios::binary);
+        if (!in_file) { std::fprintf(stderr, "error: cannot open %s\n", in_path); return 1; }
+        in = &in_file;
+    }
+
+    std::ofstream out_file;
+    std::ostream* out = &std::cout;
+    if (out_path) {
+        out_file.open(out_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out_file) { std::fprintf(stderr, "error: cannot write %s\n", out_path); return 1; }
+        out = &out_file;
+    }
+    std::ios::sync_with_stdio(false);
+
+    Engine engine;
+    std::string line;
+    unsigned long long lines = 0, errors = 0;
+    auto t0 = std::chrono::steady_clock::now();
+
+    while (std::getline(*in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        ++lines;
+
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            *out << '\n';
+            continue;
+        }
+
+        EvalResult r = engine.evaluate(std::string_view(line), opts);
+        if (r.status == EvalStatus::DomainError || r.status == EvalStatus::SyntaxError
+            || r.status == EvalStatus::BudgetExceeded) {
+            ++errors;
+            *out << r.error << '\n';
+            continue;
+        }
+        if (r.status == EvalStatus::DivideByZero) {
+            ++errors;
+            *out << "undefined\n";
+            continue;
+        }
+
+        // Same chaining as the "=" button: the next line sees this result as ANS
+        opts.ans.set_prec(r.value.get_prec());
+        opts.ans = r.value;
+        opts.ans_is_exact = r.exact;
+        if (r.exact) {
+            opts.exact_ans = r.rational;
+            *out << format_exact(r.rational) << '\n';
+            continue;
+        }
+        *out << (full ? mpf_to_string(r.value, opts.digits) : format_for_display(r.value, 20, 20)) << '\n';
+    }
+    out->flush();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stderr, "%llu lines (%llu errors) in %.3f s, %.0f lines/s\n",
+        lines, errors, secs, secs > 0 ? lines / secs : 0.0);
+
+    CacheStats cs = engine.cacheStats();
+    unsigned long long lookups = cs.hits + cs.misses;
+    std::fprintf(stderr, "expression cache: %llu hits, %llu misses (%.1f%% hit rate), %llu evictions\n",
+        cs.hits, cs.misses, lookups ? 100.0 * cs.hits / lookups : 0.0, cs.evictions);
+
+    if (trace_path) {
+        for (const trace::StageStats& st : trace::stage_stats())
+            std::fprintf(stderr, "trace: %-10s %10llu calls %12.0f ns avg %12llu ns max\n", st.name.c_str(),
+                st.calls, st.calls ? double(st.total_ns) / st.calls : 0.0, st.max_ns);
+        for (const trace::CounterStats& c : trace::counter_stats())
+            std::fprintf(stderr, "trace: %-22s %lld\n", c.name.c_str(), c.value);
+        if (!trace::write_chrome_trace(trace_path)) {
+            std::fprintf(stderr, "error: cannot write %s\n", trace_path);
+            return 1;
+        }
+    }
+    return out->good() ? 0 : 1;
+}
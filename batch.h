@@ -0,0 +1,17 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// Command-line batch evaluation:
+//
+//   numeric-engine --batch in.txt [--out out.txt] [--full] [--exact] [--digits N] [--prec BITS]
+//                  [--angle deg|rad|grad] [--time-limit MS] [--memory-limit MB]
+//                  [--dump-opt] [--trace trace.json]
+//
+// Reads one expression per line, evaluates it like the "=" button does and
+// writes one result per line. Returns a process exit code.
+int batch_main(int argc, char* argv[]);
+
+// True when argv asks for batch mode (lets main() skip creating the GUI)
+bool is_batch_invocation(int argc, char* argv[]);
+
+#endif // BATCH_H
@@ -0,0 +1,780 @@
+// numeric-engine-bench: micro-benchmarks for numeric_engine_core.
+//
+//   numeric-engine-bench [--pipeline] [--json out.json]
+//
+// Allocations are counted by routing GMP through mp_set_memory_functions and
+// by replacing the global operator new, so the numbers cover limb storage as
+// well as std::string / std::vector traffic.
+//
+// --pipeline runs only the per-stage suite (bench_pipeline); --json also
+// writes its rows to a file, so runs of two releases can be diffed.
+
+#include "engine.h"
+#include "mpmath.h"
+#include "units.h"
+#include "wordint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+static unsigned long long g_gmp_allocs = 0;
+static unsigned long long g_new_allocs = 0;
+
+static void* counting_alloc(size_t n) { ++g_gmp_allocs; return std::malloc(n); }
+static void* counting_realloc(void* p, size_t, size_t n) { ++g_gmp_allocs; return std::realloc(p, n); }
+static void counting_free(void* p, size_t) { std::free(p); }
+
+void* operator new(size_t n) {
+    ++g_new_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Peak resident set size in KiB. On Linux the high-water mark can be reset,
+// so each measurement reports its own peak; elsewhere it is the process peak.
+static void reset_peak_rss() {
+#if defined(__linux__)
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+#endif
+}
+
+static long peak_rss_kb() {
+#if defined(__linux__)
+    long kb = 0;
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), f))
+            if (std::sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+        std::fclose(f);
+    }
+    return kb;
+#elif defined(__unix__) || defined(__APPLE__)
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;   // bytes on macOS
+#else
+    return ru.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// "ans+1.5+2.5-3.5+..." with `terms` literals and as many operators. Starting
+// from ANS keeps the optimizer from folding the chain into one constant.
+static std::string make_sum(int terms) {
+    std::string s = "ans";
+    for (int i = 0; i < terms; ++i) {
+        s += (i % 3 == 2) ? "-" : "+";
+        s += std::to_string(i + 1) + ".5";
+    }
+    return s;
+}
+
+struct Measure {
+    double ns_per_eval;
+    double gmp_allocs_per_eval;
+    double new_allocs_per_eval;
+};
+
+static Measure measure(Engine& engine, const std::string& expr, int iters, const EvalOptions& opts) {
+    engine.evaluate(std::string_view(expr), opts);   // warm the cache and the stack
+
+    unsigned long long gmp0 = g_gmp_allocs, new0 = g_new_allocs;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) engine.evaluate(std::string_view(expr), opts);
+    auto t1 = std::chrono::steady_clock::now();
+
+    Measure m;
+    m.ns_per_eval = std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+    m.gmp_allocs_per_eval = double(g_gmp_allocs - gmp0) / iters;
+    m.new_allocs_per_eval = double(g_new_allocs - new0) / iters;
+    return m;
+}
+
+static void bench_eval_stack() {
+    EvalOptions opts;
+    opts.precision = 8192;
+    std::printf("== evaluation stack (cache warm, %lu-bit precision)\n", (unsigned long)opts.precision);
+    std::printf("%8s %10s %14s %16s %16s\n", "terms", "ops", "ns/eval", "gmp allocs/eval", "new allocs/eval");
+
+    Engine engine;
+    const int sizes[] = { 10, 100, 1000 };
+    Measure first = {};
+    int first_ops = 0;
+    for (int terms : sizes) {
+        std::string expr = make_sum(terms);
+        Measure m = measure(engine, expr, terms >= 1000 ? 200 : 2000, opts);
+        std::printf("%8d %10d %14.0f %16.2f %16.2f\n", terms, terms, m.ns_per_eval, m.gmp_allocs_per_eval, m.new_allocs_per_eval);
+        if (terms == sizes[0]) { first = m; first_ops = terms; }
+        else {
+            // Extra GMP allocations per extra operator: should be 0
+            double per_op = (m.gmp_allocs_per_eval - first.gmp_allocs_per_eval) / double(terms - first_ops);
+            std::printf("%8s gmp allocs per additional operator: %.4f\n", "", per_op);
+        }
+    }
+}
+
+// A long literal should stay one token: allocations must not grow with its length
+static void bench_long_literal() {
+    std::printf("\n== long literals (cache warm, 8192-bit precision)\n");
+    std::printf("%8s %14s %16s %16s\n", "digits", "ns/eval", "gmp allocs/eval", "new allocs/eval");
+
+    EvalOptions opts;
+    opts.precision = 8192;
+    Engine engine;
+    const int lengths[] = { 20, 200, 2000 };
+    for (int len : lengths) {
+        std::string expr = "1.";
+        for (int i = 0; i < len; ++i) expr.push_back(static_cast<char>('0' + (i * 7) % 10));
+        expr += "*3";
+        Measure m = measure(engine, expr, 2000, opts);
+        std::printf("%8d %14.0f %16.2f %16.2f\n", len, m.ns_per_eval, m.gmp_allocs_per_eval, m.new_allocs_per_eval);
+    }
+}
+
+// Nested calls abs(abs(...abs(1.5)...)) with the cache disabled, so every
+// evaluation parses again: the cost per level should not grow with depth
+static void bench_nesting() {
+    std::printf("\n== nested calls (cache disabled, adaptive precision)\n");
+    std::printf("%8s %14s %14s\n", "depth", "ns/eval", "ns/level");
+
+    EvalOptions opts;
+    Engine engine(0);
+    const int depths[] = { 10, 100, 500 };
+    for (int depth : depths) {
+        std::string expr;
+        for (int i = 0; i < depth; ++i) expr += "abs(";
+        expr += "1.5";
+        expr.append(static_cast<size_t>(depth), ')');
+        Measure m = measure(engine, expr, depth >= 500 ? 200 : 2000, opts);
+        std::printf("%8d %14.0f %14.1f\n", depth, m.ns_per_eval, m.ns_per_eval / depth);
+    }
+}
+
+// Adaptive precision (24 displayed digits) against the old fixed 8192 bits
+// Also checks the adaptive results: false when one is wrong
+static bool bench_precision() {
+    std::printf("\n== precision policy: adaptive (24 digits) vs fixed 8192 bits (cache disabled)\n");
+    std::printf("%-28s %12s %12s %8s %10s %24s\n", "expression", "fixed ns", "adaptive ns", "speedup", "bits used", "result");
+
+    struct Case { const char* expr; const char* expected; };
+    const Case cases[] = {
+        { "1+2", "3" },
+        { "12.5*3.75-4/7", "46.30357142857142857142" },
+        { "2^64-1", "18446744073709551615" },
+        { "sqrt(2)*sqrt(2)", "2" },
+        { "(1+1/3)^30", "5599.6656722293615821645" },
+        { "1.0000000000000000000001-1", "1e-22" },   // cancellation: retried at higher precision
+        { "1e-30+1-1", "1e-30" },
+        { "0.1+0.2-0.3", "0" },                     // only rounding residue survives: 0
+        { "sqrt(2)^2-2", "0" },
+    };
+
+    Engine engine(0);   // these fold to constants: time the compile that does the work
+    EvalOptions fixed;
+    fixed.precision = 8192;
+    EvalOptions adaptive;
+
+    bool ok = true;
+    for (const Case& c : cases) {
+        Measure mf = measure(engine, c.expr, 5000, fixed);
+        Measure ma = measure(engine, c.expr, 5000, adaptive);
+        EvalResult r = engine.evaluate(std::string_view(c.expr), adaptive);
+        std::string result = format_for_display(r.value, 20, 20);
+        std::printf("%-28s %12.0f %12.0f %7.1fx %10lu %24s\n", c.expr, mf.ns_per_eval, ma.ns_per_eval,
+            ma.ns_per_eval > 0 ? mf.ns_per_eval / ma.ns_per_eval : 0.0, (unsigned long)r.precision, result.c_str());
+        if (result != c.expected) {
+            std::fprintf(stderr, "error: %s gave %s, expected %s\n", c.expr, result.c_str(), c.expected);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Expressions that repeat a transcendental call, against the single call: with
+// common subexpressions shared (and sin/cos paired) they should cost about the same
+static void bench_optimizer() {
+    std::printf("\n== optimizer: repeated calls at 1000 digits (cache warm)\n");
+    std::printf("%-36s %12s %10s\n", "expression", "ns/eval", "vs single");
+
+    const char* pairs[][2] = {
+        { "sin(ans)", "sin(ans)^2+cos(ans)^2" },
+        { "exp(ans)", "sqr(exp(ans))-exp(ans)/2" },
+        { "ln(ans+1)", "ln(ans+1)*ln(ans+1)+ln(ans+1)" },
+    };
+
+    EvalOptions opts;
+    opts.digits = 1000;
+    opts.angle_unit = ANG_RAD;
+    opts.ans = BigFloat("0.7", 4096);
+    Engine engine;
+    for (const auto& p : pairs) {
+        Measure single = measure(engine, p[0], 200, opts);
+        Measure repeated = measure(engine, p[1], 200, opts);
+        std::printf("%-36s %12.0f\n", p[0], single.ns_per_eval);
+        std::printf("%-36s %12.0f %9.2fx\n", p[1], repeated.ns_per_eval,
+            single.ns_per_eval > 0 ? repeated.ns_per_eval / single.ns_per_eval : 0.0);
+    }
+}
+
+// The GUI's live preview evaluates the whole expression again after every
+// keystroke, with open parentheses closed and a trailing operator dropped.
+// With the cache enabled the finished transcendental parts are reused.
+static void bench_preview() {
+    std::printf("\n== live preview: every prefix of a typed expression at 1000 digits\n");
+    std::printf("%-14s %12s %14s\n", "engine", "keystrokes", "us/keystroke");
+
+    const std::string typed = "exp(1.5)*ln(7)+fact(3000)/sin(40)-sqrt(2)+atan(0.3)";
+    std::vector<std::string> prefixes;
+    for (size_t len = 1; len <= typed.size(); ++len) {
+        std::string s = typed.substr(0, len);
+        while (!s.empty() && std::string("+-*/").find(s.back()) != std::string::npos) s.pop_back();
+        long open = std::count(s.begin(), s.end(), '(') - std::count(s.begin(), s.end(), ')');
+        s.append(static_cast<size_t>(std::max(open, 0L)), ')');
+        prefixes.push_back(s);
+    }
+
+    EvalOptions opts;
+    opts.digits = 1000;
+    for (size_t capacity : { size_t(0), size_t(256) }) {
+        Engine engine(capacity);
+        auto t0 = std::chrono::steady_clock::now();
+        for (const std::string& s : prefixes) engine.evaluate(s, opts);
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / prefixes.size();
+        std::printf("%-14s %12zu %14.1f\n", capacity ? "cache on" : "cache off", prefixes.size(), us);
+    }
+}
+
+// Time from raising EvalOptions::cancel to evaluate() returning, for work that
+// would otherwise run for hours
+static void bench_cancel() {
+    std::printf("\n== cancellation latency (evaluation cancelled after 50 ms)\n");
+    std::printf("%-24s %8s %12s %12s\n", "expression", "digits", "latency us", "status");
+
+    const char* exprs[] = { "fact(1e12)", "fact(ans)+1" };
+    const unsigned digit_counts[] = { 24, 1000 };
+    for (const char* expr : exprs) {
+        for (unsigned digits : digit_counts) {
+            std::atomic<bool> cancel(false);
+            EvalOptions opts;
+            opts.digits = digits;
+            opts.ans = 1e15;
+            opts.cancel = &cancel;
+
+            Engine engine;
+            EvalResult r;
+            std::chrono::steady_clock::time_point done;
+            std::thread worker([&] {
+                r = engine.evaluate(expr, opts);
+                done = std::chrono::steady_clock::now();
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            auto raised = std::chrono::steady_clock::now();
+            cancel = true;
+            worker.join();
+
+            double us = std::chrono::duration<double, std::micro>(done - raised).count();
+            std::printf("%-24s %8u %12.1f %12s\n", expr, digits, us,
+                r.status == EvalStatus::Cancelled ? "cancelled" : "finished");
+        }
+    }
+}
+
+// Time until evaluate() gives up under a 50 ms budget: a factorial whose
+// length is known is refused up front, anything else runs into the deadline
+static void bench_budget() {
+    std::printf("\n== time budget of 50 ms\n");
+    std::printf("%-24s %12s %22s\n", "expression", "returned ms", "result");
+
+    const char* exprs[] = { "fact(1e12)", "fact(3e6)", "fact(ans)+1", "fact(2e6)*fact(2e6)" };
+    for (const char* expr : exprs) {
+        EvalOptions opts;
+        opts.ans = 1e12;
+        opts.time_limit_ms = 50;
+        Engine engine;
+        auto t0 = std::chrono::steady_clock::now();
+        EvalResult r = engine.evaluate(expr, opts);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%-24s %12.2f %22s\n", expr, ms,
+            r.ok() ? format_for_display(r.value).c_str() : r.error.c_str());
+    }
+}
+
+// Short expressions with only + - * / and integer powers, in floating point
+// (the old fixed 8192 bits, and the adaptive default with and without the
+// program cache) against exact mode with and without its cache
+static void bench_exact() {
+    std::printf("\n== exact rational mode (us per expression)\n");
+    std::printf("%-24s %10s %10s %10s %10s %10s %20s\n",
+        "expression", "8192 bits", "adaptive", "cached", "exact", "cached", "exact result");
+
+    const char* exprs[] = { "1/3*3", "0.1+0.2-0.3", "1+2*3-4/5^2", "(2/3)^5+7/8", "123456789*987654321/3" };
+    for (const char* expr : exprs) {
+        std::vector<Token> tokens = tokenize(expr);
+        auto time_us = [&](Engine& engine, const EvalOptions& opts) {
+            const int iters = 20000;
+            engine.evaluate(tokens, opts);   // warm up
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < iters; ++i) engine.evaluate(tokens, opts);
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        };
+
+        Engine cold(0), warm;
+        EvalOptions fixed, adaptive, exact;
+        fixed.precision = 8192;
+        exact.exact = true;
+        double t_fixed = time_us(cold, fixed);
+        double t_adaptive = time_us(cold, adaptive);
+        double t_cached = time_us(warm, adaptive);
+        double t_exact = time_us(cold, exact);
+        double t_exact_cached = time_us(warm, exact);
+        std::printf("%-24s %10.2f %10.2f %10.2f %10.2f %10.2f %20s\n", expr, t_fixed, t_adaptive, t_cached,
+            t_exact, t_exact_cached, format_exact(warm.evaluate(tokens, exact).rational).c_str());
+    }
+}
+
+// Integer-only expressions, which the integer tier works out in mpz_class
+// before the optimizer; uncached, so every run pays for the fold
+static void bench_integers() {
+    std::printf("\n== integer tier (us per expression, uncached)\n");
+    std::printf("%-28s %10s %10s %24s\n", "expression", "adaptive", "8192 bits", "result");
+
+    const char* exprs[] = { "554*35+10/7", "2^200+1-2^200", "(10^30+7) mod 10", "fact(300)/fact(298)",
+        "fact(1000)/fact(999)", "123456789^9-123456789^9+1" };
+    for (const char* expr : exprs) {
+        std::vector<Token> tokens = tokenize(expr);
+        auto time_us = [&](Engine& engine, const EvalOptions& opts) {
+            const int iters = 2000;
+            engine.evaluate(tokens, opts);   // warm up
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < iters; ++i) engine.evaluate(tokens, opts);
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        };
+
+        Engine cold(0);
+        EvalOptions adaptive, fixed;
+        fixed.precision = 8192;
+        double t_adaptive = time_us(cold, adaptive);
+        double t_fixed = time_us(cold, fixed);
+        std::printf("%-28s %10.2f %10.2f %24s\n", expr, t_adaptive, t_fixed,
+            format_for_display(cold.evaluate(tokens, adaptive).value, 20, 20).c_str());
+    }
+}
+
+// Programmer view words: one operation at each width, then whole
+// expressions as typed and a pasted 4096-digit bit string
+static void bench_words() {
+    std::printf("\n== programmer words (ns per operation)\n");
+    std::printf("%8s %10s %10s %10s %10s %10s\n", "width", "add", "mul", "rol", "div", "popcount");
+
+    auto time_ns = [](int iters, auto&& fn) {
+        fn();   // warm up
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) fn();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+    };
+
+    const unsigned widths[] = { 8, 16, 32, 64, 128, 4096 };
+    for (unsigned width : widths) {
+        WordInt a = WordInt::fromMpz(width, mpz_class("0x9E3779B97F4A7C15F39CC0605CEDC834", 0) * 12345);
+        WordInt b(width, 0x1234567u);
+        WordInt r(width);
+        const int iters = width > 64 ? 200000 : 2000000;
+        volatile unsigned sink = 0;   // keeps the results live
+        auto op = [&](WordOp o) {
+            return time_ns(iters, [&] { word_apply(o, a, b, r); sink = sink + r.isZero(); });
+        };
+        double t_add = op(WordOp::Add), t_mul = op(WordOp::Mul), t_rol = op(WordOp::Rol), t_div = op(WordOp::Div);
+        double t_pop = time_ns(iters, [&] { sink = sink + a.popcount(); });
+        std::printf("%8u %10.1f %10.1f %10.1f %10.1f %10.1f\n", width, t_add, t_mul, t_rol, t_div, t_pop);
+    }
+
+    std::printf("%-36s %8s %12s\n", "expression", "width", "us");
+    std::string bits(4096, '1');
+    bits[0] = '0';
+    std::vector<Token> pasted = { Token::number(bits) };
+    // the GUI commits hex entries as number tokens; tokenize() reads "A5" as a name
+    auto num = [](const char* digits) { return Token::number(digits); };
+    struct Case { const char* name; std::vector<Token> tokens; unsigned width; int radix; };
+    const Case cases[] = {
+        { "A5 AND F0 OR 3 LSH 2", { num("A5"), "AND", num("F0"), "OR", num("3"), "LSH", num("2") }, 64, 16 },
+        { "(ANS+1)*7 XOR FFFF mod 3", { "(", "ANS", "+", num("1"), ")", "*", num("7"), "XOR", num("FFFF"), "mod", num("3") }, 16, 16 },
+        { "pasted 4096-digit bit string", pasted, 64, 2 },
+        { "pasted 4096-digit bit string", pasted, 4096, 2 },
+    };
+    for (const Case& c : cases) {
+        WordOptions opts;
+        opts.width = c.width;
+        opts.radix = c.radix;
+        opts.ans = WordInt(c.width, 41);
+        double us = time_ns(20000, [&] { evaluate_words(c.tokens, opts); }) / 1000.0;
+        std::printf("%-36s %8u %12.3f\n", c.name, c.width, us);
+    }
+
+    // The base panel's four strings, from the digit tables against mpz_get_str
+    std::printf("%8s %8s %12s %12s\n", "width", "radix", "toString ns", "mpz ns");
+    for (unsigned width : { 64u, 4096u }) {
+        WordInt v = WordInt::fromMpz(width, (mpz_class(1) << width) / 7 * 5);
+        mpz_class z = v.toMpz(false);
+        const int iters = width > 64 ? 20000 : 500000;
+        volatile size_t sink = 0;
+        for (int radix : { 16, 10, 8, 2 }) {
+            double t_word = time_ns(iters, [&] { sink = sink + v.toString(radix).size(); });
+            double t_mpz = time_ns(iters, [&] { sink = sink + z.get_str(radix).size(); });
+            std::printf("%8u %8d %12.1f %12.1f\n", width, radix, t_word, t_mpz);
+        }
+    }
+}
+
+// Unit conversion: folding a pair of units into one conversion, then one
+// value through it exactly and as a double
+static void bench_units() {
+    std::printf("\n== unit conversion (ns)\n");
+    std::printf("%-14s %10s %10s %10s\n", "conversion", "build", "exact", "double");
+
+    auto time_ns = [](int iters, auto&& fn) {
+        fn();   // warm up
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) fn();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+    };
+
+    struct Case { const char* category; const char* from; const char* to; };
+    const Case cases[] = { { "Length", "ft", "m" }, { "Temperature", "°F", "°C" }, { "Pressure", "psi", "mmHg" } };
+    for (const Case& c : cases) {
+        const UnitCategory* category = find_unit_category(c.category);
+        const Unit& from = *find_unit(*category, c.from);
+        const Unit& to = *find_unit(*category, c.to);
+        volatile double sink = 0;
+        double t_build = time_ns(100000, [&] { sink = sink + UnitConversion(from, to).apply(1.0); });
+        UnitConversion conv(from, to);
+        mpq_class x(12345, 100);
+        double t_exact = time_ns(200000, [&] { sink = sink + conv.apply(x).get_num().get_si(); });
+        double v = 123.45;
+        double t_double = time_ns(10000000, [&] { v = conv.apply(v) * 1e-3 + 100; });
+        sink = sink + v;
+        std::string name = std::string(c.from) + " -> " + c.to;
+        int pad = 14;   // printf counts bytes; widen by the UTF-8 continuation bytes of "°"
+        for (char ch : name) pad += (static_cast<unsigned char>(ch) & 0xC0) == 0x80;
+        std::printf("%-*s %10.1f %10.1f %10.2f\n", pad, name.c_str(), t_build, t_exact, t_double);
+    }
+}
+
+// Formatting a result for "=": the display form plus the raw 80 digits from
+// separate conversions, as before DecimalForm, against one shared conversion;
+// then printing every digit of results up to a million digits long
+static void bench_format() {
+    std::printf("\n== result formatting (us)\n");
+    std::printf("%8s %14s %14s\n", "bits", "separate", "DecimalForm");
+
+    auto time_us = [](int iters, auto&& fn) {
+        fn();   // warm up
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) fn();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+    };
+
+    for (mp_bitcnt_t bits : { 64, 1024, 8192 }) {
+        BigFloat x(2, bits);
+        x = sqrt(x) * 1e10;
+        double t_sep = time_us(20000, [&] { format_for_display(x, 20, 20); mpf_to_string(x, 80); });
+        double t_one = time_us(20000, [&] { DecimalForm d(x); d.display(20, 20); d.plain(80); });
+        std::printf("%8lu %14.2f %14.2f\n", bits, t_sep, t_one);
+    }
+
+    std::printf("%8s %14s\n", "digits", "plain ms");
+    for (size_t digits : { 1000, 10000, 100000, 1000000 }) {
+        BigFloat x(2, static_cast<mp_bitcnt_t>(digits * 3.3219280948873623) + 64);
+        x = sqrt(x);
+        double us = time_us(digits >= 100000 ? 3 : 50, [&] { DecimalForm(x, digits).plain(digits); });
+        std::printf("%8zu %14.3f\n", digits, us / 1000);
+    }
+}
+
+// Multiprecision exp/log kernels at increasing precision
+static void bench_kernels() {
+    std::printf("\n== exp/log kernels (us per call)\n");
+    std::printf("%8s %10s %10s %10s %10s\n", "digits", "exp", "log", "pow", "sinh");
+
+    const unsigned digit_counts[] = { 100, 1000, 10000 };
+    for (unsigned digits : digit_counts) {
+        mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(digits * 3.3219280948873623) + 16;
+        BigFloat x("1.2345678901234567890123456789", bits), y("0.75", bits), r(0, bits);
+        int iters = digits >= 10000 ? 3 : (digits >= 1000 ? 50 : 2000);
+
+        auto time_us = [&](auto&& fn) {
+            fn();   // warm up
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < iters; ++i) fn();
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        };
+        double t_exp  = time_us([&] { big_exp(r.get_mpf_t(), x.get_mpf_t()); });
+        double t_log  = time_us([&] { big_log(r.get_mpf_t(), x.get_mpf_t()); });
+        double t_pow  = time_us([&] { big_pow(r.get_mpf_t(), x.get_mpf_t(), y.get_mpf_t()); });
+        double t_sinh = time_us([&] { big_sinh(r.get_mpf_t(), x.get_mpf_t()); });
+        std::printf("%8u %10.1f %10.1f %10.1f %10.1f\n", digits, t_exp, t_log, t_pow, t_sinh);
+    }
+}
+
+// Constants: cost of computing them once vs. a hit in the constant cache
+static void bench_constants() {
+    std::printf("\n== constants (us to compute, ns per cache hit)\n");
+    std::printf("%8s %10s %10s %10s %10s %12s\n", "digits", "pi", "e", "ln2", "ln10", "cached pi");
+
+    const unsigned digit_counts[] = { 100, 1000, 10000, 100000 };
+    for (unsigned digits : digit_counts) {
+        mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(digits * 3.3219280948873623) + 16;
+        BigFloat r(0, bits);
+        int iters = digits >= 100000 ? 1 : (digits >= 10000 ? 5 : 200);
+
+        auto time_us = [&](auto&& fn) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < iters; ++i) fn();
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        };
+        double t_pi   = time_us([&] { compute_pi(r.get_mpf_t()); });
+        double t_e    = time_us([&] { compute_e(r.get_mpf_t()); });
+        double t_ln2  = time_us([&] { compute_ln2(r.get_mpf_t()); });
+        double t_ln10 = time_us([&] { compute_ln10(r.get_mpf_t()); });
+
+        math_constant(MathConstant::Pi, bits);
+        const int hits = 100000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < hits; ++i) math_constant(MathConstant::Pi, bits);
+        auto t1 = std::chrono::steady_clock::now();
+        double t_hit = std::chrono::duration<double, std::nano>(t1 - t0).count() / hits;
+
+        std::printf("%8u %10.1f %10.1f %10.1f %10.1f %12.1f\n", digits, t_pi, t_e, t_ln2, t_ln10, t_hit);
+    }
+}
+
+// Trig kernels against the double functions they replace
+static void bench_trig() {
+    std::printf("\n== trig kernels (us per call)\n");
+    std::printf("%8s %10s %10s %10s %10s %10s\n", "digits", "sin+cos", "sin deg", "sin 1e22", "atan", "asin");
+
+    {
+        volatile double x = 1.2345678901234567, acc = 0;
+        const int iters = 1000000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) acc = acc + std::sin(x) + std::cos(x);
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) acc = acc + std::atan(x);
+        auto t2 = std::chrono::steady_clock::now();
+        std::printf("%8s %10.3f %10s %10s %10.3f %10s\n", "double",
+            std::chrono::duration<double, std::micro>(t1 - t0).count() / iters, "-", "-",
+            std::chrono::duration<double, std::micro>(t2 - t1).count() / iters, "-");
+    }
+
+    const unsigned digit_counts[] = { 20, 100, 1000, 10000 };
+    for (unsigned digits : digit_counts) {
+        mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(digits * 3.3219280948873623) + 16;
+        BigFloat x("1.2345678901234567890123456789", bits), deg("123.456", bits), big("1e22", bits);
+        BigFloat a("0.4321", bits), s(0, bits), c(0, bits);
+        int iters = digits >= 10000 ? 3 : (digits >= 1000 ? 50 : 2000);
+
+        auto time_us = [&](auto&& fn) {
+            fn();   // warm up (and fill the pi cache)
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < iters; ++i) fn();
+            auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        };
+        double t_sc   = time_us([&] { big_sin_cos(s.get_mpf_t(), c.get_mpf_t(), x.get_mpf_t()); });
+        double t_deg  = time_us([&] { big_sin_cos_turn(s.get_mpf_t(), c.get_mpf_t(), deg.get_mpf_t(), 360); });
+        double t_big  = time_us([&] { big_sin_cos(s.get_mpf_t(), c.get_mpf_t(), big.get_mpf_t()); });
+        double t_atan = time_us([&] { big_atan(s.get_mpf_t(), a.get_mpf_t()); });
+        double t_asin = time_us([&] { big_asin(s.get_mpf_t(), a.get_mpf_t()); });
+        std::printf("%8u %10.1f %10.1f %10.1f %10.1f %10.1f\n", digits, t_sc, t_deg, t_big, t_atan, t_asin);
+    }
+}
+
+// ===== Pipeline suite =====
+// Every stage of an evaluation, for representative expressions at fixed
+// precisions from 64 to 65536 bits:
+//
+//   tokenize            text -> tokens
+//   compile             parse, optimize and lower (Engine::compile, cache off)
+//   evaluate            run the cached program: the cost of "=" on a repeat
+//   mpf_to_string       80 significant digits of the result
+//   format_for_display  the display form of the result
+//
+// pow_int and the factorial loop are measured as the evaluate stage of the
+// "pow_int" (ans^1000003) and "factorial" (fact(ans)) cases.
+
+struct StageRow {
+    std::string stage, expr_case;
+    unsigned long bits;
+    int iters;
+    double ns_per_op, gmp_allocs_per_op, new_allocs_per_op;
+    long peak_rss_kb;
+};
+
+// Runs fn until about 30 ms have passed (at least 3 times) after a warm-up
+template <class Fn>
+static StageRow time_stage(const char* stage, const char* expr_case, unsigned long bits, Fn&& fn) {
+    auto w0 = std::chrono::steady_clock::now();
+    fn();
+    double once = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - w0).count();
+    int iters = static_cast<int>(std::min(100000.0, std::max(3.0, 30e6 / std::max(once, 1.0))));
+
+    reset_peak_rss();
+    unsigned long long gmp0 = g_gmp_allocs, new0 = g_new_allocs;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) fn();
+    auto t1 = std::chrono::steady_clock::now();
+
+    StageRow r;
+    r.stage = stage;
+    r.expr_case = expr_case;
+    r.bits = bits;
+    r.iters = iters;
+    r.ns_per_op = std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+    r.gmp_allocs_per_op = double(g_gmp_allocs - gmp0) / iters;
+    r.new_allocs_per_op = double(g_new_allocs - new0) / iters;
+    r.peak_rss_kb = peak_rss_kb();
+    return r;
+}
+
+static void print_stage_row(const StageRow& r) {
+    std::printf("%-20s %-10s %6lu %14.0f %12.2f %12.2f %10ld\n", r.stage.c_str(), r.expr_case.c_str(),
+        r.bits, r.ns_per_op, r.gmp_allocs_per_op, r.new_allocs_per_op, r.peak_rss_kb);
+}
+
+static std::vector<StageRow> bench_pipeline() {
+    std::printf("\n== pipeline stages\n");
+    std::printf("%-20s %-10s %6s %14s %12s %12s %10s\n",
+        "stage", "case", "bits", "ns/op", "gmp allocs", "new allocs", "peak KiB");
+
+    std::string nested = "ans";
+    const char* funcs[] = { "sin", "sqrt", "atan", "abs", "cos" };
+    for (int i = 0; i < 20; ++i) nested = std::string(funcs[i % 5]) + "(" + nested + ")";
+    std::string literal = "ans*1.";
+    for (int i = 0; i < 2000; ++i) literal.push_back(static_cast<char>('0' + (i * 7 + 3) % 10));
+
+    struct Case { const char* name; std::string expr; const char* ans; };
+    const Case cases[] = {
+        { "short",     "12.5*ans-4/7+ans^2", "1.25" },
+        { "nested",    nested,               "0.7" },
+        { "sum10k",    make_sum(10000),      "0.5" },
+        { "literal",   literal,              "3" },
+        { "pow_int",   "ans^1000003",        "1.0000001" },
+        { "factorial", "fact(ans)",          "3000" },
+    };
+    const mp_bitcnt_t precisions[] = { 64, 256, 1024, 8192, 65536 };
+
+    std::vector<StageRow> rows;
+    auto add = [&](const StageRow& r) { print_stage_row(r); rows.push_back(r); };
+
+    for (const Case& c : cases) {
+        add(time_stage("tokenize", c.name, 0, [&] { tokenize(c.expr); }));
+        std::vector<Token> tokens = tokenize(c.expr);
+
+        for (mp_bitcnt_t bits : precisions) {
+            EvalOptions opts;
+            opts.precision = bits;
+            opts.angle_unit = ANG_RAD;
+            opts.ans = BigFloat(c.ans, bits);
+
+            Engine cold(0), warm;
+            add(time_stage("compile", c.name, bits, [&] { cold.compile(tokens, opts); }));
+            add(time_stage("evaluate", c.name, bits, [&] { warm.evaluate(tokens, opts); }));
+
+            BigFloat value = warm.evaluate(tokens, opts).value;
+            add(time_stage("mpf_to_string", c.name, bits, [&] { mpf_to_string(value, 80); }));
+            add(time_stage("format_for_display", c.name, bits, [&] { format_for_display(value, 20, 20); }));
+        }
+    }
+    return rows;
+}
+
+static bool write_json(const char* path, const std::vector<StageRow>& rows) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"suite\": \"pipeline\",\n  \"results\": [\n");
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const StageRow& r = rows[i];
+        std::fprintf(f, "    {\"stage\": \"%s\", \"case\": \"%s\", \"bits\": %lu, \"iterations\": %d, "
+            "\"ns_per_op\": %.1f, \"gmp_allocs_per_op\": %.2f, \"new_allocs_per_op\": %.2f, \"peak_rss_kb\": %ld}%s\n",
+            r.stage.c_str(), r.expr_case.c_str(), r.bits, r.iters, r.ns_per_op,
+            r.gmp_allocs_per_op, r.new_allocs_per_op, r.peak_rss_kb, i + 1 < rows.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    bool pipeline_only = false;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if (a == "--pipeline") pipeline_only = true;
+        else if (a == "--json" && i + 1 < argc) json_path = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: numeric-engine-bench [--pipeline] [--json out.json]\n");
+            return 2;
+        }
+    }
+    mp_set_memory_functions(counting_alloc, counting_realloc, counting_free);
+
+    if (pipeline_only) {
+        std::vector<StageRow> rows = bench_pipeline();
+        if (json_path && !write_json(json_path, rows)) {
+            std::fprintf(stderr, "error: cannot write %s\n", json_path);
+            return 1;
+        }
+        return 0;
+    }
+
+    bench_eval_stack();
+    bench_long_literal();
+    bench_nesting();
+    bool results_ok = bench_precision();
+    bench_optimizer();
+    bench_preview();
+    bench_cancel();
+    bench_budget();
+    bench_exact();
+    bench_integers();
+    bench_words();
+    bench_units();
+    bench_format();
+    bench_constants();
+    bench_kernels();
+    bench_trig();
+    std::vector<StageRow> rows = bench_pipeline();
+    if (json_path && !write_json(json_path, rows)) {
+        std::fprintf(stderr, "error: cannot write %s\n", json_path);
+        return 1;
+    }
+    return results_ok ? 0 : 1;
+}
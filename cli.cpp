@@ -0,0 +1,14 @@
+#include "batch.h"
+#include "convert.h"
+#include <gmp.h>
+
+// Headless entry point (numeric-engine-cli); needs no Qt at build or run time
+int main(int argc, char *argv[])
+{
+    // same default as the GUI (see main.cpp); evaluation precision is per call
+    mpf_set_default_prec(256);
+
+    if (is_convert_invocation(argc, argv))
+        return convert_main(argc, argv);
+    return batch_main(argc, argv);
+}
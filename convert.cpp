@@ -0,0 +1,449 @@
+#include "convert.h"
+#include "engine.h"
+#include "units.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void print_convert_usage() {
+    std::fprintf(stderr,
+        "usage: numeric-engine --convert <in.csv> --column <N|name> --from <unit> --to <unit> [--out <out.csv>]\n"
+        "                      [--header] [--delimiter C] [--threads N] [--digits N] [--exact]\n"
+        "  --column N|name    field to convert: 1-based, or its name in the header line (implies --header)\n"
+        "  --from, --to       unit symbols or names from the Converter, e.g. ft, m, \"°F\", kelvin\n"
+        "  --header           copy the first line through unchanged\n"
+        "  --delimiter C      field separator, one character or \"tab\" (default ',')\n"
+        "  --threads N        worker threads (default one per core)\n"
+        "  --digits N         significant digits written (default 15, at most 17)\n"
+        "  --exact            convert each value as an exact fraction instead of a double; much slower\n"
+        "Fields that are not numbers (empty, \"NA\") and short lines are copied unchanged and counted as\n"
+        "skipped. Quoted fields may contain the delimiter but not a line break.\n");
+}
+
+bool is_convert_invocation(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--convert") == 0) return true;
+    return false;
+}
+
+// ===== Mapped input =====
+// A read-only file mapped one window at a time: a whole 10 GB file would fit
+// the address space of a 64-bit process, but the pages it touched would stay
+// resident until the end.
+
+namespace {
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const char* path);
+    uint64_t size() const { return bytes; }
+
+    // Bytes [offset, offset + len) of the file, valid until the next map()
+    // or unmap(); nullptr on failure
+    const char* map(uint64_t offset, size_t len);
+    void unmap();
+
+private:
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    uint64_t bytes = 0;
+    void* view = nullptr;
+    size_t view_len = 0;
+};
+
+#if defined(_WIN32)
+
+MappedFile::~MappedFile() {
+    unmap();
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+
+bool MappedFile::open(const char* path) {
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) return false;
+    bytes = static_cast<uint64_t>(size.QuadPart);
+    if (bytes == 0) return true;   // an empty file cannot be mapped
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    return mapping != nullptr;
+}
+
+const char* MappedFile::map(uint64_t offset, size_t len) {
+    unmap();
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    uint64_t start = offset - offset % si.dwAllocationGranularity;
+    view_len = static_cast<size_t>(offset - start) + len;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(start >> 32), static_cast<DWORD>(start), view_len);
+    return view ? static_cast<const char*>(view) + (offset - start) : nullptr;
+}
+
+void MappedFile::unmap() {
+    if (view) UnmapViewOfFile(view);
+    view = nullptr;
+}
+
+#else
+
+MappedFile::~MappedFile() {
+    unmap();
+    if (fd >= 0) ::close(fd);
+}
+
+bool MappedFile::open(const char* path) {
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    bytes = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+const char* MappedFile::map(uint64_t offset, size_t len) {
+    unmap();
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = offset - offset % page;
+    view_len = static_cast<size_t>(offset - start) + len;
+    void* p = mmap(nullptr, view_len, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(start));
+    if (p == MAP_FAILED) return nullptr;
+    view = p;
+    madvise(view, view_len, MADV_SEQUENTIAL);   // read ahead, drop behind
+    return static_cast<const char*>(view) + (offset - start);
+}
+
+void MappedFile::unmap() {
+    if (view) munmap(view, view_len);
+    view = nullptr;
+}
+
+#endif
+
+struct ConvertJob {
+    size_t column = 0;   // 0-based
+    char delimiter = ',';
+    int digits = 15;
+    bool exact = false;
+    const UnitConversion* conversion = nullptr;
+};
+
+struct ChunkStats {
+    uint64_t lines = 0;
+    uint64_t skipped = 0;
+};
+
+} // namespace
+
+// ===== Fields =====
+
+// Field `column` of the line [p, end) including any quotes; false when the
+// line has fewer fields
+static bool findField(const char* p, const char* end, char delimiter, size_t column,
+    const char*& field, const char*& field_end) {
+    for (size_t i = 0;; ++i) {
+        const char* q = p;
+        if (q < end && *q == '"') {   // to the closing quote; "" is an escaped one
+            for (++q; q < end; ++q) {
+                if (*q != '"') continue;
+                if (q + 1 < end && q[1] == '"') ++q;
+                else break;
+            }
+        }
+        q = static_cast<const char*>(std::memchr(q, delimiter, static_cast<size_t>(end - q)));
+        if (!q) q = end;
+        if (i == column) {
+            field = p;
+            field_end = q;
+            return true;
+        }
+        if (q == end) return false;
+        p = q + 1;
+    }
+}
+
+// A field without surrounding blanks and quotes
+static void trimField(const char*& p, const char*& end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) --end;
+    if (end - p >= 2 && *p == '"' && end[-1] == '"') {
+        ++p;
+        --end;
+    }
+}
+
+// The whole of a trimmed field as a double, read in place
+static bool parseField(const char* p, const char* end, double& v) {
+    trimField(p, end);
+    if (p < end && *p == '+') ++p;
+    std::from_chars_result r = std::from_chars(p, end, v);
+    return r.ec == std::errc() && r.ptr == end && p < end;
+}
+
+// ===== Conversion =====
+
+// Convert the complete lines [p, end) into out, a block of lines at a time:
+// find and parse every field of the block, convert the values in one loop,
+// then write the lines with their new fields
+static void convertChunk(const char* p, const char* end, const ConvertJob& job, std::string& out, ChunkStats& stats) {
+    const size_t kBlock = 4096;
+    struct Line {
+        const char* begin;
+        const char* field;       // nullptr when there is nothing to convert
+        const char* field_end;
+        const char* next;        // past the '\n'
+    };
+    std::vector<Line> lines;
+    std::vector<double> values;
+    lines.reserve(kBlock);
+    values.reserve(kBlock);
+    std::string text;
+    char buf[64];
+
+    while (p < end) {
+        lines.clear();
+        values.clear();
+        for (; p < end && lines.size() < kBlock; ++stats.lines) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            Line l = { p, nullptr, nullptr, nl ? nl + 1 : end };
+            const char* eol = nl ? nl : end;
+            if (eol > p && eol[-1] == '\r') --eol;
+            double v = 0;
+            if (findField(p, eol, job.delimiter, job.column, l.field, l.field_end)
+                && (job.exact || parseField(l.field, l.field_end, v))) {
+                values.push_back(v);
+            }
+            else {
+                l.field = nullptr;
+                values.push_back(0);
+            }
+            lines.push_back(l);
+            p = l.next;
+        }
+
+        if (!job.exact) {
+            const UnitConversion& conv = *job.conversion;
+            for (double& v : values) v = conv.apply(v);
+        }
+
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const Line& l = lines[i];
+            const char* digits = buf;
+            size_t len = 0;
+            if (l.field && !job.exact) {
+                std::to_chars_result r = std::to_chars(buf, buf + sizeof(buf), values[i], std::chars_format::general, job.digits);
+                len = static_cast<size_t>(r.ptr - buf);
+            }
+            else if (l.field) {
+                const char* f = l.field;
+                const char* fe = l.field_end;
+                trimField(f, fe);
+                mpq_class q;
+                if (parse_exact(std::string(f, fe), q)) {
+                    q = job.conversion->apply(q);
+                    text = format_exact(q);
+                    if (text.find('/') != std::string::npos)
+                        text = mpf_to_string(BigFloat(q, static_cast<mp_bitcnt_t>(job.digits * 3.33) + 64), job.digits);
+                    digits = text.data();
+                    len = text.size();
+                }
+            }
+            if (len == 0) {
+                ++stats.skipped;
+                out.append(l.begin, l.next);
+                continue;
+            }
+            out.append(l.begin, l.field);
+            out.append(digits, len);
+            out.append(l.field_end, l.next);
+        }
+    }
+}
+
+// The unit called `name` in the category that also has `other`
+static const Unit* findUnitPair(const std::string& name, const std::string& other, const Unit*& other_unit) {
+    size_t count = 0;
+    const UnitCategory* categories = unit_categories(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Unit* u = find_unit(categories[i], name);
+        other_unit = find_unit(categories[i], other);
+        if (u && other_unit) return u;
+    }
+    return nullptr;
+}
+
+int convert_main(int argc, char* argv[]) {
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+    std::string column_arg, from_name, to_name;
+    bool header = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    ConvertJob job;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--convert" && i + 1 < argc) in_path = argv[++i];
+        else if (a == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (a == "--column" && i + 1 < argc) column_arg = argv[++i];
+        else if (a == "--from" && i + 1 < argc) from_name = argv[++i];
+        else if (a == "--to" && i + 1 < argc) to_name = argv[++i];
+        else if (a == "--header") header = true;
+        else if (a == "--exact") job.exact = true;
+        else if (a == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (a == "--digits" && i + 1 < argc) job.digits = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        else if (a == "--delimiter" && i + 1 < argc) {
+            std::string d = argv[++i];
+            if (d == "tab") job.delimiter = '\t';
+            else if (d.size() == 1 && d[0] != '"') job.delimiter = d[0];
+            else { print_convert_usage(); return 2; }
+        }
+        else { print_convert_usage(); return 2; }
+    }
+    if (!in_path || column_arg.empty() || from_name.empty() || to_name.empty() || threads == 0
+        || job.digits <= 0 || (!job.exact && job.digits > 17)) {
+        print_convert_usage();
+        return 2;
+    }
+
+    const Unit* to = nullptr;
+    const Unit* from = findUnitPair(from_name, to_name, to);
+    if (!from) {
+        std::fprintf(stderr, "error: %s and %s are not units of one category\n", from_name.c_str(), to_name.c_str());
+        return 2;
+    }
+    UnitConversion conversion(*from, *to);
+    job.conversion = &conversion;
+
+    bool by_name = column_arg.find_first_not_of("0123456789") != std::string::npos;
+    if (by_name) header = true;
+    else if (std::strtoul(column_arg.c_str(), nullptr, 10) == 0) { print_convert_usage(); return 2; }
+    else job.column = std::strtoul(column_arg.c_str(), nullptr, 10) - 1;
+
+    MappedFile file;
+    if (!file.open(in_path)) { std::fprintf(stderr, "error: cannot open %s\n", in_path); return 1; }
+
+    std::ofstream out_file;
+    std::ostream* out = &std::cout;
+    if (out_path) {
+        out_file.open(out_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out_file) { std::fprintf(stderr, "error: cannot write %s\n", out_path); return 1; }
+        out = &out_file;
+    }
+    std::ios::sync_with_stdio(false);
+
+    // Each round maps a window, cuts it back to its last line break and
+    // splits it between the threads; their output goes out in order before
+    // the next round. Only one window and one round of output are in memory.
+    size_t window = size_t(16) << 20;
+    std::vector<std::string> outputs(threads);
+    std::vector<ChunkStats> stats(threads);
+    ChunkStats total;
+    uint64_t pos = 0;
+    auto t0 = std::chrono::steady_clock::now();
+
+    while (pos < file.size()) {
+        size_t len = static_cast<size_t>(std::min<uint64_t>(window, file.size() - pos));
+        const char* begin = file.map(pos, len);
+        if (!begin) { std::fprintf(stderr, "error: cannot map %s\n", in_path); return 1; }
+        const char* end = begin + len;
+        if (pos + len < file.size()) {
+            const char* nl = end;
+            while (nl > begin && nl[-1] != '\n') --nl;
+            if (nl == begin) {   // a line longer than the window
+                window *= 2;
+                continue;
+            }
+            end = nl;
+        }
+
+        if (header) {
+            const char* nl = static_cast<const char*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+            const char* next = nl ? nl + 1 : end;
+            const char* eol = (nl && nl > begin && nl[-1] == '\r') ? nl - 1 : (nl ? nl : end);
+            if (by_name) {
+                bool found = false;
+                const char* f;
+                const char* fe;
+                for (size_t i = 0; !found && findField(begin, eol, job.delimiter, i, f, fe); ++i) {
+                    trimField(f, fe);
+                    found = column_arg == std::string(f, fe);
+                    job.column = i;
+                }
+                if (!found) {
+                    std::fprintf(stderr, "error: no column named %s\n", column_arg.c_str());
+                    return 2;
+                }
+            }
+            out->write(begin, next - begin);
+            header = false;
+            pos += static_cast<uint64_t>(next - begin);
+            begin = next;
+        }
+
+        // One chunk per thread, each ending on a line break
+        std::vector<const char*> cuts = { begin };
+        for (unsigned t = 1; t < threads; ++t) {
+            const char* c = std::max(cuts.back(), begin + (end - begin) * t / threads);
+            const char* nl = static_cast<const char*>(std::memchr(c, '\n', static_cast<size_t>(end - c)));
+            cuts.push_back(nl ? nl + 1 : end);
+        }
+        cuts.push_back(end);
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            outputs[t].clear();   // keeps its capacity for the next round
+            outputs[t].reserve(static_cast<size_t>(cuts[t + 1] - cuts[t]) * 5 / 4);
+            stats[t] = ChunkStats();
+            if (t + 1 < threads)
+                workers.emplace_back(convertChunk, cuts[t], cuts[t + 1], std::cref(job), std::ref(outputs[t]), std::ref(stats[t]));
+        }
+        convertChunk(cuts[threads - 1], cuts[threads], job, outputs[threads - 1], stats[threads - 1]);
+        for (std::thread& w : workers) w.join();
+
+        for (unsigned t = 0; t < threads; ++t) {
+            out->write(outputs[t].data(), static_cast<std::streamsize>(outputs[t].size()));
+            total.lines += stats[t].lines;
+            total.skipped += stats[t].skipped;
+        }
+        pos += static_cast<uint64_t>(end - begin);
+    }
+    file.unmap();
+    out->flush();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double mb = file.size() / 1e6;
+    std::fprintf(stderr, "%llu lines (%llu skipped) in %.3f s, %.1f MB/s\n",
+        static_cast<unsigned long long>(total.lines), static_cast<unsigned long long>(total.skipped),
+        secs, secs > 0 ? mb / secs : 0.0);
+    return out->good() ? 0 : 1;
+}
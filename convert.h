@@ -0,0 +1,18 @@
+#ifndef CONVERT_H
+#define CONVERT_H
+
+// Command-line unit conversion of one column of a CSV file:
+//
+//   numeric-engine --convert in.csv --column N|name --from UNIT --to UNIT [--out out.csv]
+//                  [--header] [--delimiter C] [--threads N] [--digits N] [--exact]
+//
+// Uses the Converter's unit tables (units.h). The input is memory-mapped a
+// window at a time and each window is split between worker threads on line
+// boundaries, so memory use does not depend on the file size. Every other
+// field and line is copied through unchanged. Returns a process exit code.
+int convert_main(int argc, char* argv[]);
+
+// True when argv asks for convert mode (lets main() skip creating the GUI)
+bool is_convert_invocation(int argc, char* argv[]);
+
+#endif // CONVERT_H
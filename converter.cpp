@@ -1,5 +1,9 @@
 #include "converter.h"
 
+#include "engine.h"   // format_exact, format_for_display
+
+#include <limits>
+
 converter::converter(QWidget *parent)
 	: QMainWindow(parent)
 {
@@ -7,7 +11,89 @@ converter::converter(QWidget *parent)
 
 	// Explicitly set the window flags to a regular window
 	setWindowFlags(Qt::Window);
+
+	// The result is only shown; the status bar has it in full
+	ui.finalQuantity->setReadOnly(true);
+	ui.finalQuantity->setRange(-std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+
+	size_t count = 0;
+	const UnitCategory* categories = unit_categories(count);
+	for (size_t i = 0; i < count; ++i)
+		ui.unitTypeSelection->addItem(QString::fromUtf8(categories[i].name));
+
+	connect(ui.unitTypeSelection, &QComboBox::currentIndexChanged, this, &converter::showCategory);
+	connect(ui.sourceUnitSelect, &QComboBox::currentIndexChanged, this, &converter::unitsChanged);
+	connect(ui.finalUnitSelect, &QComboBox::currentIndexChanged, this, &converter::unitsChanged);
+	connect(ui.swapUnitsButton, &QPushButton::clicked, this, &converter::swapUnits);
+	// keyboard tracking is on, so this fires on every keystroke
+	connect(ui.sourceUnitQuantity, &QDoubleSpinBox::valueChanged, this, &converter::updateResult);
+
+	showCategory(0);
 }
 
 converter::~converter()
 {}
+
+void converter::showCategory(int index)
+{
+	size_t count = 0;
+	const UnitCategory* categories = unit_categories(count);
+	if (index < 0 || static_cast<size_t>(index) >= count) return;
+	category = &categories[index];
+
+	// Below zero only where zero is not the bottom of the scale
+	bool affine = false;
+	for (size_t i = 0; i < category->count; ++i)
+		affine = affine || category->units[i].offset.num != 0;
+	ui.sourceUnitQuantity->setRange(affine ? -1e15 : 0, 1e15);
+
+	conversion.reset();
+	ui.sourceUnitSelect->clear();
+	ui.finalUnitSelect->clear();
+	for (size_t i = 0; i < category->count; ++i) {
+		ui.sourceUnitSelect->addItem(QString::fromUtf8(category->units[i].symbol));
+		ui.finalUnitSelect->addItem(QString::fromUtf8(category->units[i].symbol));
+	}
+	ui.sourceUnitSelect->setCurrentIndex(0);
+	ui.finalUnitSelect->setCurrentIndex(category->count > 1 ? 1 : 0);
+	unitsChanged();
+}
+
+// Fold the two units into one conversion, so typing only multiplies
+void converter::unitsChanged()
+{
+	int from = ui.sourceUnitSelect->currentIndex();
+	int to = ui.finalUnitSelect->currentIndex();
+	if (!category || from < 0 || to < 0) return;   // mid-way through refilling
+	conversion.emplace(category->units[from], category->units[to]);
+	updateResult();
+}
+
+void converter::swapUnits()
+{
+	int from = ui.sourceUnitSelect->currentIndex();
+	ui.sourceUnitSelect->setCurrentIndex(ui.finalUnitSelect->currentIndex());
+	ui.finalUnitSelect->setCurrentIndex(from);
+}
+
+void converter::updateResult()
+{
+	if (!conversion) return;
+
+	// What the box shows, read as the decimal it is rather than its nearest double
+	QDoubleSpinBox* source = ui.sourceUnitQuantity;
+	mpq_class x;
+	if (!parse_exact(QString::number(source->value(), 'f', source->decimals()).toStdString(), x)) return;
+	mpq_class y = conversion->apply(x);
+	ui.finalQuantity->setValue(y.get_d());
+
+	// Exact when the decimal terminates and is short enough to read
+	std::string text = format_exact(y);
+	if (text.find('/') != std::string::npos || text.size() > 40)
+		text = "≈ " + format_for_display(BigFloat(y, 256));
+	else
+		text = "= " + text;
+	const Unit& from = category->units[ui.sourceUnitSelect->currentIndex()];
+	const Unit& to = category->units[ui.finalUnitSelect->currentIndex()];
+	ui.statusBar->showMessage(QString::fromUtf8((format_exact(x) + " " + from.symbol + " " + text + " " + to.symbol).c_str()));
+}
@@ -3,6 +3,10 @@
 #include <QMainWindow>
 #include "ui_converter.h"
 
+#include <optional>
+
+#include "units.h"
+
 class converter : public QMainWindow
 {
 	Q_OBJECT
@@ -11,7 +15,15 @@ public:
 	converter(QWidget *parent = nullptr);
 	~converter();
 
+private slots:
+	void showCategory(int index);
+	void unitsChanged();
+	void swapUnits();
+	void updateResult();
+
 private:
 	Ui::converterClass ui;
-};
 
+	const UnitCategory* category = nullptr;
+	std::optional<UnitConversion> conversion;   // for the selected pair of units
+};
@@ -0,0 +1,2235 @@
+#include "engine.h"
+#include "mpmath.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ===== Evaluation context =====
+
+// Per-evaluation state threaded through the evaluator (replaces the old
+// g_eval_div0 / last_eval_error / last_answer / g_angle_unit globals)
+class EvalStack;
+class FoldCache;
+
+struct EvalContext {
+    const EvalOptions& opts;
+    ProgramCache* cache;      // compiled programs of the owning Engine (may be null)
+    FoldCache* folds = nullptr;   // costly constant folds of the owning Engine (may be null)
+    EvalStack& stack;         // reusable interpreter stack of the owning Engine
+    mp_bitcnt_t prec;         // working precision of this attempt, in bits
+    long lost_bits = 0;       // worst cancellation seen in an add/sub, in bits
+    bool div0 = false;        // a division (or mod) by zero happened somewhere
+    std::string error;        // first domain error message, e.g. "Error: ln domain (0,∞)"
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    unsigned polls = 0;       // calls of poll(); the clock is read on every 64th
+
+    EvalContext(const EvalOptions& o, ProgramCache* c, EvalStack& st, mp_bitcnt_t p)
+        : opts(o), cache(c), stack(st), prec(p) {}
+};
+
+// Thrown out of the interpreter when EvalOptions::cancel is raised or a budget
+// runs out; caught in Engine::evaluateAt
+struct EvalCancelled {};
+struct EvalOverBudget { const char* message; };
+
+static bool hasDeadline(const EvalContext& ctx) {
+    return ctx.deadline != std::chrono::steady_clock::time_point::max();
+}
+
+// Called between instructions and inside long loops
+static inline void poll(EvalContext& ctx) {
+    if (ctx.opts.cancel && ctx.opts.cancel->load(std::memory_order_relaxed)) throw EvalCancelled();
+    if ((++ctx.polls & 63) == 0 && hasDeadline(ctx) && std::chrono::steady_clock::now() > ctx.deadline)
+        throw EvalOverBudget{ "Error: time limit" };
+}
+
+// rop = base^exp by binary exponentiation, in place. `sq` is scratch for the
+// running square; rop must not alias base or sq.
+static void pow_int(mpf_t rop, const mpf_t base, long long exp, mpf_t sq, EvalContext& ctx) {
+    mpf_set_ui(rop, 1);
+    if (exp == 0) return;
+    bool neg = (exp < 0);
+    unsigned long long n = neg ? (unsigned long long)(-exp) : (unsigned long long)exp;
+    mpf_set(sq, base);
+    while (n) {
+        poll(ctx);
+        if (n & 1ULL) mpf_mul(rop, rop, sq);
+        if (n > 1)    mpf_mul(sq, sq, sq);
+        n >>= 1ULL;
+    }
+    if (neg) mpf_ui_div(rop, 1, rop);
+}
+
+// ===== Bytecode: the optimized syntax tree flattened into opcodes + parsed constants =====
+enum class OpCode : unsigned char {
+    PUSH_CONST,   // push consts[arg]
+    PUSH_ANS,     // push opts.ans
+    NEG,          // unary minus
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    POW,
+    MOD,
+    CALL,         // apply FuncId(arg) to its arguments on top of the stack
+    SINCOS,       // sin of the top in place, its cos into temp[arg]
+    COSSIN,       // cos of the top in place, its sin into temp[arg]
+    SAVE,         // copy the top into temp[arg] (a value used again later)
+    LOAD          // push temp[arg]
+};
+
+struct Instr {
+    OpCode op;
+    unsigned arg;   // constant index for PUSH_CONST, FuncId for CALL, temp index otherwise
+};
+
+struct Program {
+    std::vector<Instr> code;
+    std::vector<BigFloat> consts;   // literals parsed once with mpf_set_str at compile time
+    size_t max_depth = 0;           // deepest evaluation stack the code needs
+    unsigned temps = 0;             // values kept for reuse by SAVE/LOAD
+    long lost_bits = 0;             // cancellation in additions folded at compile time
+};
+
+// Evaluation stack owned by the Engine and reused across runs. Slots keep their
+// limbs between evaluations, so operators work in place (mpf_add(dst, a, b))
+// and run without any heap allocation once the stack is warm.
+class EvalStack {
+public:
+    void prepare(size_t depth, size_t n_temps, mp_bitcnt_t prec) {
+        if (prec != slot_prec) {
+            for (auto& v : slots) v.set_prec(prec);
+            for (auto& v : temps) v.set_prec(prec);
+            tmp.set_prec(prec);
+            slot_prec = prec;
+        }
+        while (slots.size() < depth) slots.emplace_back(0, prec);
+        while (temps.size() < n_temps) temps.emplace_back(0, prec);
+    }
+
+    mpf_ptr at(size_t i) { return slots[i].get_mpf_t(); }
+    BigFloat& value(size_t i) { return slots[i]; }
+    BigFloat& temp(size_t i) { return temps[i]; }
+    mpf_ptr scratch() { return tmp.get_mpf_t(); }
+    std::vector<mpq_class>& fractions() { return exact; }   // for runExact
+
+private:
+    std::vector<BigFloat> slots;
+    std::vector<BigFloat> temps;
+    std::vector<mpq_class> exact;
+    BigFloat tmp;
+    mp_bitcnt_t slot_prec = 0;
+};
+
+// Number of arguments each function takes; pi and e are written without parentheses
+static unsigned funcArity(FuncId f) {
+    switch (f) {
+    case FuncId::Pi: case FuncId::E: return 0;
+    case FuncId::Xroot: return 2;
+    default: return 1;
+    }
+}
+
+// ===== Syntax tree =====
+// Nodes live in one vector and refer to their children by index. A node's
+// children are a run of `count` entries in Ast::kids starting at `first`,
+// so a function call carries its whole argument list.
+
+enum class NodeKind : unsigned char {
+    Literal,   // `first` indexes Ast::literals
+    Ans,
+    Neg,       // one child
+    Binary,    // two children, `op` says which operator
+    Call       // funcArity(func) children
+};
+
+struct Node {
+    NodeKind kind = NodeKind::Literal;
+    OpCode op = OpCode::ADD;
+    FuncId func = FuncId::Abs;
+    unsigned first = 0;
+    unsigned count = 0;
+};
+
+struct Ast {
+    std::vector<Node> nodes;
+    std::vector<unsigned> kids;
+    std::vector<BigFloat> literals;   // at the working precision
+    unsigned root = 0;
+
+    unsigned child(unsigned id, unsigned i) const { return kids[nodes[id].first + i]; }
+
+    unsigned add(NodeKind kind, const unsigned* args, unsigned count) {
+        Node n;
+        n.kind = kind;
+        n.first = static_cast<unsigned>(kids.size());
+        n.count = count;
+        kids.insert(kids.end(), args, args + count);
+        nodes.push_back(n);
+        return static_cast<unsigned>(nodes.size() - 1);
+    }
+    // A literal constructed in place from BigFloat constructor arguments
+    template <class... Args>
+    unsigned literal(Args&&... args) {
+        Node n;
+        n.first = static_cast<unsigned>(literals.size());
+        literals.emplace_back(std::forward<Args>(args)...);
+        nodes.push_back(n);
+        return static_cast<unsigned>(nodes.size() - 1);
+    }
+    unsigned binary(OpCode op, unsigned a, unsigned b) {
+        const unsigned args[2] = { a, b };
+        unsigned id = add(NodeKind::Binary, args, 2);
+        nodes[id].op = op;
+        return id;
+    }
+    unsigned call(FuncId f, const std::vector<unsigned>& args) {
+        unsigned id = add(NodeKind::Call, args.data(), static_cast<unsigned>(args.size()));
+        nodes[id].func = f;
+        return id;
+    }
+};
+
+// Recursive descent over the token stream, one token at a time. Precedence is
+// the one the shunting-yard evaluator had, loosest first:
+//
+//   expr    := term (('+' | '-') term)*
+//   term    := power (('*' | '/' | mod) power | power)*    juxtaposition multiplies: 2pi
+//   power   := unary ('^' unary)*                          left-associative
+//   unary   := '-' unary | primary                         so -2^2 is 4
+//   primary := number+ | ANS | pi | e | func '(' expr (',' expr)* ')' | '(' expr ')'
+//
+// Number tokens that follow each other form one literal, as they did when the
+// buffer was spliced into text. Parentheses still open at the end of the input
+// are closed implicitly. Anything else that does not fit throws
+// std::invalid_argument, which the caller reports as a syntax error.
+class Parser {
+public:
+    Parser(const Token* first, const Token* last, mp_bitcnt_t prec, Ast& ast)
+        : t(first), end(last), prec(prec), ast(ast)
+    {
+        // no regrowth: vector<BigFloat> copies every value when it moves
+        size_t n = static_cast<size_t>(last - first) + 1;
+        ast.nodes.reserve(n);
+        ast.kids.reserve(2 * n);
+        ast.literals.reserve(n);
+    }
+
+    void parse() {
+        TRACE_SCOPE("parse");
+        ast.root = (t == end) ? literal("0") : expr();
+        if (t != end) fail();   // stray ')' or ','
+    }
+
+    // Also write each literal's text to `out`, indexed like Ast::literals
+    void keepSpellings(std::vector<std::string>& out) {
+        spellings = &out;
+        out.reserve(static_cast<size_t>(end - t) + 1);
+    }
+
+private:
+    // Bound on nested parentheses, calls and unary minus signs, so hostile
+    // input cannot exhaust the C++ stack
+    static const int kMaxNesting = 1000;
+
+    struct Nest {
+        Parser& p;
+        explicit Nest(Parser& parser) : p(parser) { if (++p.nesting > kMaxNesting) fail(); }
+        ~Nest() { --p.nesting; }
+    };
+
+    [[noreturn]] static void fail() { throw std::invalid_argument("syntax"); }
+
+    unsigned literal(const std::string& text) {
+        if (spellings) spellings->push_back(text);
+        return ast.literal(text, prec);
+    }
+
+    bool at(TokenKind k) const { return t != end && t->kind == k; }
+    bool atOperator(char c) const { return t != end && t->isOperator(c); }
+    bool atOperand() const {
+        return at(TokenKind::Number) || at(TokenKind::Ans) || at(TokenKind::Function) || at(TokenKind::LParen);
+    }
+
+    unsigned expr() {
+        Nest nest(*this);
+        unsigned lhs = term();
+        while (atOperator('+') || atOperator('-')) {
+            OpCode op = ((t++)->op == '+') ? OpCode::ADD : OpCode::SUB;
+            lhs = ast.binary(op, lhs, term());
+        }
+        return lhs;
+    }
+
+    unsigned term() {
+        unsigned lhs = power();
+        for (;;) {
+            OpCode op;
+            if (atOperator('*')) op = OpCode::MUL;
+            else if (atOperator('/')) op = OpCode::DIV;
+            else if (atOperator('%')) op = OpCode::MOD;
+            else if (atOperand()) { lhs = ast.binary(OpCode::MUL, lhs, power()); continue; }
+            else return lhs;
+            ++t;
+            lhs = ast.binary(op, lhs, power());
+        }
+    }
+
+    unsigned power() {
+        unsigned lhs = unary();
+        while (atOperator('^')) {
+            ++t;
+            lhs = ast.binary(OpCode::POW, lhs, unary());
+        }
+        return lhs;
+    }
+
+    unsigned unary() {
+        if (!atOperator('-')) return primary();
+        ++t;
+        Nest nest(*this);
+        unsigned arg = unary();
+        return ast.add(NodeKind::Neg, &arg, 1);
+    }
+
+    unsigned primary() {
+        if (t == end) fail();
+        switch (t->kind) {
+        case TokenKind::Number: {
+            const Token* start = t++;
+            if (!at(TokenKind::Number)) return literal(start->text);
+            std::string merged = start->text;
+            while (at(TokenKind::Number)) merged += (t++)->text;
+            return literal(merged);
+        }
+        case TokenKind::Ans:
+            ++t;
+            return ast.add(NodeKind::Ans, nullptr, 0);
+        case TokenKind::LParen: {
+            ++t;
+            unsigned inner = expr();
+            close();
+            return inner;
+        }
+        case TokenKind::Function:
+            return call();
+        default:
+            fail();
+        }
+    }
+
+    unsigned call() {
+        FuncId f = (t++)->func;
+        std::vector<unsigned> args;
+        if (funcArity(f) > 0) {
+            if (!at(TokenKind::LParen)) fail();
+            ++t;
+            args.push_back(expr());
+            while (at(TokenKind::Comma)) {
+                ++t;
+                args.push_back(expr());
+            }
+            if (args.size() != funcArity(f)) fail();
+            close();
+        }
+        return ast.call(f, args);
+    }
+
+    // ')' ending a group or an argument list; missing ones at the end are implied
+    void close() {
+        if (at(TokenKind::RParen)) ++t;
+        else if (t != end) fail();
+    }
+
+    const Token* t;
+    const Token* end;
+    mp_bitcnt_t prec;
+    Ast& ast;
+    std::vector<std::string>* spellings = nullptr;
+    int nesting = 0;
+};
+
+// pi and e at the working precision, copied from the shared constant cache
+static BigFloat big_pi(const EvalContext& ctx) {
+    BigFloat pi(0, ctx.prec);
+    mpf_set(pi.get_mpf_t(), math_constant(MathConstant::Pi, ctx.prec).get_mpf_t());
+    return pi;
+}
+
+// --- Conversions ---
+static BigFloat rad_to_deg(const EvalContext& ctx, const BigFloat& r) { return r * 180 / big_pi(ctx); }
+static BigFloat rad_to_grad(const EvalContext& ctx, const BigFloat& r) { return r * 200 / big_pi(ctx); }
+
+// sin and cos of v in the selected unit. Degrees and gradians are reduced
+// exactly modulo a full turn, so they never go through an inexact v*pi/180.
+static void sin_cos_in_unit(const EvalContext& ctx, BigFloat& s, BigFloat& c, const BigFloat& v) {
+    switch (ctx.opts.angle_unit) {
+    case ANG_RAD:  big_sin_cos(s.get_mpf_t(), c.get_mpf_t(), v.get_mpf_t()); break;
+    case ANG_GRAD: big_sin_cos_turn(s.get_mpf_t(), c.get_mpf_t(), v.get_mpf_t(), 400); break;
+    default:       big_sin_cos_turn(s.get_mpf_t(), c.get_mpf_t(), v.get_mpf_t(), 360); break;
+    }
+}
+static BigFloat from_radians(const EvalContext& ctx, const BigFloat& r) {
+    switch (ctx.opts.angle_unit) {
+    case ANG_RAD:  return r;
+    case ANG_GRAD: return rad_to_grad(ctx, r);
+    default:       return rad_to_deg(ctx, r);
+    }
+}
+
+// Round x to `bits` significant bits, to nearest (ties away from zero)
+static void round_to_bits(BigFloat& x, mp_bitcnt_t bits) {
+    mpf_ptr p = x.get_mpf_t();
+    if (mpf_sgn(p) == 0) return;
+    long e = 0;
+    mpf_get_d_2exp(&e, p);                       // |x| = m 2^e, 0.5 <= m < 1
+    long shift = static_cast<long>(bits) - e;    // x 2^shift has `bits` integer bits
+    bool neg = mpf_sgn(p) < 0;
+    mpf_abs(p, p);
+    if (shift >= 0) mpf_mul_2exp(p, p, shift); else mpf_div_2exp(p, p, -shift);
+    BigFloat half(0.5, 64);
+    mpf_add(p, p, half.get_mpf_t());
+    mpf_floor(p, p);
+    if (shift >= 0) mpf_div_2exp(p, p, shift); else mpf_mul_2exp(p, p, -shift);
+    if (neg) mpf_neg(p, p);
+}
+
+// Bits kept of ANS, constants and function results. The last 32 bits only
+// hold the rounding error of the kernels, so they are rounded away here; that
+// keeps log10(1000) at 3 rather than 2.999... for fact() and xroot() to see.
+static mp_bitcnt_t spliceBits(const EvalContext& ctx) {
+    return ctx.prec > 64 ? ctx.prec - 32 : ctx.prec;
+}
+
+// a = a + b (or a - b), recording in ctx.lost_bits how many leading bits
+// cancelled. An exact zero from non-zero operands counts as losing everything.
+static void add_sub_tracked(EvalContext& ctx, mpf_ptr a, mpf_srcptr b, bool sub) {
+    if (mpf_sgn(a) == 0 || mpf_sgn(b) == 0) {
+        if (sub) mpf_sub(a, a, b); else mpf_add(a, a, b);
+        return;
+    }
+    long ea = 0, eb = 0, er = 0;
+    mpf_get_d_2exp(&ea, a);
+    mpf_get_d_2exp(&eb, b);
+    if (sub) mpf_sub(a, a, b); else mpf_add(a, a, b);
+
+    long lost;
+    if (mpf_sgn(a) == 0) lost = static_cast<long>(ctx.prec);
+    else {
+        mpf_get_d_2exp(&er, a);
+        lost = std::max(ea, eb) - er;
+    }
+    if (lost > ctx.lost_bits) ctx.lost_bits = lost;
+}
+
+// A lower bound on one step of n! (mpf_mul_ui by a word), used to refuse a
+// factorial that cannot finish before the deadline
+static const double kMinFactorStepNs = 5.0;
+
+// Apply f in place: its arguments are args[0 .. funcArity(f)) and the result
+// replaces args[0]. A domain error records its message and leaves 0, so the
+// rest of the expression still runs, as it does after a division by zero.
+static void callFunction(EvalContext& ctx, FuncId f, BigFloat* args) {
+    BigFloat& x = args[0];
+    mpf_ptr r = x.get_mpf_t();
+    auto fail = [&](const char* msg) { ctx.error = msg; mpf_set_ui(r, 0); };
+
+    switch (f) {
+    // plain arithmetic: exact up to the working precision, nothing to round off
+    case FuncId::Sqr:
+        mpf_mul(r, r, r);
+        return;
+    case FuncId::Recip:
+        if (mpf_sgn(r) == 0) ctx.div0 = true;   // 1/0 → “undefined”
+        else mpf_ui_div(r, 1, r);
+        return;
+    case FuncId::Percent:
+        mpf_div_ui(r, r, 100);
+        return;
+    case FuncId::Mod:       // FUNC_MOD(x) only groups its argument
+        return;
+
+    case FuncId::Pi: mpf_set(r, math_constant(MathConstant::Pi, ctx.prec).get_mpf_t()); break;
+    case FuncId::E:  mpf_set(r, math_constant(MathConstant::E, ctx.prec).get_mpf_t()); break;
+
+    // circular trig (inputs depend on unit)
+    case FuncId::Sin: {
+        BigFloat c(0, ctx.prec);
+        sin_cos_in_unit(ctx, x, c, x);
+        break;
+    }
+    case FuncId::Cos: {
+        BigFloat s(0, ctx.prec);
+        sin_cos_in_unit(ctx, s, x, x);
+        break;
+    }
+    case FuncId::Tan: {
+        BigFloat s(0, ctx.prec), c(0, ctx.prec);
+        sin_cos_in_unit(ctx, s, c, x);
+        if (c == 0) {          // tan(90°): “undefined” like division by zero
+            ctx.div0 = true;
+            mpf_set_ui(r, 0);
+            return;
+        }
+        mpf_div(r, s.get_mpf_t(), c.get_mpf_t());
+        break;
+    }
+    // inverse circular trig (outputs shown in selected unit)
+    case FuncId::Asin:
+        if (!big_asin(r, r)) return fail("Error: asin domain [-1,1]");
+        x = from_radians(ctx, x);
+        break;
+    case FuncId::Acos:
+        if (!big_acos(r, r)) return fail("Error: acos domain [-1,1]");
+        x = from_radians(ctx, x);
+        break;
+    case FuncId::Atan:
+        big_atan(r, r);
+        x = from_radians(ctx, x);
+        break;
+
+    case FuncId::Sinh:
+        if (!big_sinh(r, r)) return fail("Error: overflow");
+        break;
+    case FuncId::Cosh:
+        if (!big_cosh(r, r)) return fail("Error: overflow");
+        break;
+    case FuncId::Tanh:
+        big_tanh(r, r);
+        break;
+    case FuncId::Asinh:     // principal value: ℝ → ℝ
+        big_asinh(r, r);
+        break;
+    case FuncId::Acosh:     // domain: x >= 1
+        if (!big_acosh(r, r)) return fail("Error: acosh domain [1, +inf)");
+        break;
+    case FuncId::Atanh:     // domain: |x| < 1
+        if (!big_atanh(r, r)) return fail("Error: atanh domain (-1, 1)");
+        break;
+
+    case FuncId::Ln:
+        if (!big_log(r, r)) return fail("Error: ln domain (0,∞)");
+        break;
+    case FuncId::Log10:
+        if (!big_log10(r, r)) return fail("Error: log domain (0,∞)");
+        break;
+    case FuncId::Exp:
+        if (!big_exp(r, r)) return fail("Error: overflow");
+        break;
+    case FuncId::Exp10:
+        if (!big_exp10(r, r)) return fail("Error: overflow");
+        break;
+
+    case FuncId::Sqrt:
+        if (mpf_sgn(r) < 0) { mpf_set_ui(r, 0); return; }   // no real root: 0
+        mpf_sqrt(r, r);
+        break;
+    case FuncId::Abs:
+        mpf_abs(r, r);
+        break;
+    case FuncId::Fact: {
+        if (mpf_sgn(r) < 0) { mpf_set_ui(r, 0); return; }
+        if (!mpf_fits_slong_p(r)) {   // more multiplications than could ever finish
+            if (hasDeadline(ctx)) throw EvalOverBudget{ "Error: time limit" };
+            return fail("Error: overflow");
+        }
+        long long n = mpf_get_si(r);
+        if (hasDeadline(ctx)) {
+            // n multiplications of kMinFactorStepNs each at the very least
+            double left = std::chrono::duration<double, std::nano>(ctx.deadline - std::chrono::steady_clock::now()).count();
+            if (static_cast<double>(n) * kMinFactorStepNs > left) throw EvalOverBudget{ "Error: time limit" };
+        }
+        mpf_set_ui(r, 1);
+        for (long long k = 2; k <= n; ++k) {
+            if ((k & 1023) == 0) poll(ctx);
+            mpf_mul_ui(r, r, static_cast<unsigned long>(k));
+        }
+        break;
+    }
+    case FuncId::Xroot: {
+        // xroot(x, y) = y^(1/x); a negative y only has a real root for odd integer x
+        mpf_ptr y = args[1].get_mpf_t();
+        if (mpf_sgn(r) == 0) return;   // root 0 is undefined: 0
+        bool odd_root = mpf_integer_p(r) && mpf_fits_slong_p(r) && (mpf_get_si(r) & 1);
+        bool neg = mpf_sgn(y) < 0;
+        if (neg && !odd_root) return fail("Error: xroot domain");
+        mpf_ui_div(r, 1, r);
+        mpf_abs(y, y);
+        if (!big_pow(r, y, r)) return fail("Error: overflow");
+        if (neg) mpf_neg(r, r);
+        break;
+    }
+    }
+    round_to_bits(x, spliceBits(ctx));
+}
+
+// a = a op b for the binary operators, in place. `scratch` is a free value at
+// the working precision.
+static void applyBinary(EvalContext& ctx, OpCode op, mpf_ptr a, mpf_ptr b, mpf_ptr scratch) {
+    switch (op) {
+    case OpCode::ADD: add_sub_tracked(ctx, a, b, false); break;
+    case OpCode::SUB: add_sub_tracked(ctx, a, b, true); break;
+    case OpCode::MUL: mpf_mul(a, a, b); break;
+    case OpCode::DIV:
+        if (mpf_sgn(b) == 0) { ctx.div0 = true; mpf_set_ui(a, 0); } // do not attempt inf/NaN
+        else mpf_div(a, a, b);
+        break;
+    case OpCode::POW: {
+        // Use full-precision integer exponent when possible
+        double bd = mpf_get_d(b);
+        long long bi = static_cast<long long>(bd);
+        if (mpf_sgn(a) == 0 && bd < 0) {   // 0^-y → “undefined” like 1/0
+            ctx.div0 = true;
+            mpf_set_ui(a, 0);
+        }
+        else if (std::fabs(bd - static_cast<double>(bi)) < 1e-12) {
+            // move the base into b's slot (b is consumed) so the result lands in a's
+            mpf_swap(a, b);
+            pow_int(a, b, bi, scratch, ctx);
+        }
+        else {
+            // non-integer exponent: exp(b ln a)
+            bool neg_base = mpf_sgn(a) < 0;
+            if (!big_pow(a, a, b)) {
+                ctx.error = neg_base ? "Error: pow domain" : "Error: overflow";
+                mpf_set_ui(a, 0);
+            }
+        }
+        break;
+    }
+    case OpCode::MOD:
+        if (mpf_sgn(b) == 0) {     // x mod 0 → “undefined” like division by zero
+            ctx.div0 = true;
+            mpf_set_ui(a, 0);
+        }
+        else {
+            // C/C++ fmod semantics: sign follows the dividend (a)
+            mpf_set_d(a, std::fmod(mpf_get_d(a), mpf_get_d(b)));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static BigFloat runProgram(EvalContext& ctx, const Program& prog) {
+    TRACE_SCOPE("run");
+    EvalStack& st = ctx.stack;
+    st.prepare(prog.max_depth, prog.temps, ctx.prec);
+    if (prog.lost_bits > ctx.lost_bits) ctx.lost_bits = prog.lost_bits;   // from folded additions
+    size_t sp = 0;   // number of live slots
+
+    for (const Instr& in : prog.code) {
+        poll(ctx);
+        switch (in.op) {
+        case OpCode::PUSH_CONST:
+            mpf_set(st.at(sp++), prog.consts[in.arg].get_mpf_t());
+            break;
+        case OpCode::PUSH_ANS: {
+            BigFloat& v = st.value(sp++);
+            mpf_set(v.get_mpf_t(), ctx.opts.ans.get_mpf_t());
+            round_to_bits(v, spliceBits(ctx));
+            break;
+        }
+        case OpCode::LOAD:
+            mpf_set(st.at(sp++), st.temp(in.arg).get_mpf_t());
+            break;
+        case OpCode::SAVE:
+            mpf_set(st.temp(in.arg).get_mpf_t(), st.at(sp - 1));
+            break;
+        case OpCode::NEG:
+            mpf_neg(st.at(sp - 1), st.at(sp - 1));
+            break;
+        case OpCode::CALL: {
+            FuncId f = static_cast<FuncId>(in.arg);
+            sp -= funcArity(f);
+            callFunction(ctx, f, &st.value(sp++));
+            break;
+        }
+        case OpCode::SINCOS:
+        case OpCode::COSSIN: {
+            BigFloat& x = st.value(sp - 1);
+            BigFloat& other = st.temp(in.arg);
+            if (in.op == OpCode::SINCOS) sin_cos_in_unit(ctx, x, other, x);
+            else sin_cos_in_unit(ctx, other, x, x);
+            round_to_bits(x, spliceBits(ctx));
+            round_to_bits(other, spliceBits(ctx));
+            break;
+        }
+        default:
+            applyBinary(ctx, in.op, st.at(sp - 2), st.at(sp - 1), st.scratch());   // result in the lower slot
+            --sp;
+            break;
+        }
+    }
+    return BigFloat(st.at(sp - 1));
+}
+
+// ===== LRU caches =====
+// Least-recently-used map from a string key to V; capacity 0 keeps nothing.
+template <class V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+
+    const V* find(const std::string& key) {
+        auto it = index.find(key);
+        if (it == index.end()) { ++counters.misses; return nullptr; }
+        ++counters.hits;
+        lru.splice(lru.begin(), lru, it->second);   // mark as most recently used
+        return &it->second->second;
+    }
+
+    void insert(const std::string& key, V value) {
+        if (capacity == 0) return;
+        if (index.count(key)) return;
+        if (lru.size() >= capacity) {
+            index.erase(lru.back().first);
+            lru.pop_back();
+            ++counters.evictions;
+        }
+        lru.emplace_front(key, std::move(value));
+        index.emplace(lru.front().first, lru.begin());
+    }
+
+    void clear() { index.clear(); lru.clear(); }
+
+    CacheStats stats() const {
+        CacheStats s = counters;
+        s.size = lru.size();
+        s.capacity = capacity;
+        return s;
+    }
+
+private:
+    typedef std::list<std::pair<std::string, V>> List;
+
+    size_t capacity;
+    List lru;                                                 // front = most recently used
+    std::unordered_map<std::string_view, typename List::iterator> index;   // views into lru keys
+    CacheStats counters;
+};
+
+// Compiled programs, keyed by the token stream written out compactly plus the
+// angle unit and the working precision (constants are parsed at that precision)
+class ProgramCache : public LruCache<std::shared_ptr<const Program>> {
+public:
+    using LruCache::LruCache;
+};
+
+// Results of costly constant folds (see Optimizer::fold), kept across compiles
+class FoldCache : public LruCache<BigFloat> {
+public:
+    using LruCache::LruCache;
+};
+
+static const size_t kFoldCacheCapacity = 64;
+
+// ===== Optimizer =====
+// Rewrites the parsed tree into a smaller DAG before it is lowered:
+//
+//  - constant folding: a node whose operands are all literals is evaluated
+//    now, at the working precision and with the interpreter's own code, so
+//    the literal is bit for bit what evaluation would have produced. Nodes
+//    that hit a domain error or a division by zero are left for run time,
+//    which reports them.
+//  - common subexpressions: equal nodes are merged (hash-consing), so
+//    sqr(sin(x)) and sin(x)+sin(x) compute sin(x) once.
+//  - strength reduction: x^2 and x*x become sqr(x), x^-1 recip(x), x^1 and
+//    --x just x, and x/c becomes x*(1/c) when 1/c is exact (c a power of
+//    two). x/3 stays a division: x*(1/3) would round twice and turn 6/3
+//    into 1.999... at a fixed precision.
+//
+// The sin and cos of one argument are paired up later, in lower().
+
+struct OptimizerStats {
+    size_t before = 0;   // nodes from the parser
+    size_t after = 0;    // nodes left that the program still uses
+    unsigned folded = 0, shared = 0, reduced = 0;
+    unsigned reused = 0;   // folds answered by the Engine's FoldCache
+};
+
+class Optimizer {
+public:
+    // Takes over in's literals. The operands of a fold live in the first two
+    // slots of the interpreter stack, which is idle while compiling.
+    Optimizer(EvalContext& ctx, Ast& in)
+        : in(in), fold_ctx(ctx.opts, nullptr, ctx.stack, ctx.prec), folds(ctx.folds)
+    {
+        fold_ctx.deadline = ctx.deadline;
+        ctx.stack.prepare(2, 0, ctx.prec);
+        reg = &ctx.stack.value(0);
+        scratch = ctx.stack.scratch();
+        // every input node adds at most two (x/c adds 1/c and the product)
+        size_t cap = 16;
+        while (cap < 4 * in.nodes.size()) cap *= 2;
+        table.assign(cap, NONE);
+        out.nodes.reserve(2 * in.nodes.size());
+        out.kids.reserve(in.kids.size() + in.nodes.size());
+        out.literals = std::move(in.literals);
+        out.literals.reserve(2 * out.literals.size() + 1);
+    }
+
+    Ast run() {
+        TRACE_SCOPE("optimize");
+        std::vector<unsigned> map(in.nodes.size());
+        for (unsigned id = 0; id < in.nodes.size(); ++id) {   // children come before their parents
+            const Node& n = in.nodes[id];
+            unsigned args[2] = { 0, 0 };
+            for (unsigned i = 0; i < n.count && i < 2; ++i) args[i] = map[in.child(id, i)];
+            map[id] = (n.kind == NodeKind::Literal) ? literal(n.first) : rewrite(n, args);
+        }
+        out.root = map[in.root];
+        stats.before = in.nodes.size();
+        return std::move(out);
+    }
+
+    long lostBits() const { return fold_ctx.lost_bits; }
+
+    OptimizerStats stats;
+
+private:
+    static constexpr unsigned NONE = ~0u;
+
+    // Everything the hash-consing compares; no node has more than two children
+    struct Key {
+        NodeKind kind;
+        OpCode op;
+        FuncId func;
+        unsigned x, y;
+    };
+
+    bool isLiteral(unsigned id) const { return out.nodes[id].kind == NodeKind::Literal; }
+    mpf_srcptr value(unsigned id) const { return out.literals[out.nodes[id].first].get_mpf_t(); }
+
+    unsigned rewrite(const Node& n, const unsigned* args) {
+        if (n.kind != NodeKind::Ans && n.count <= 2
+            && (n.count < 1 || isLiteral(args[0])) && (n.count < 2 || isLiteral(args[1]))) {
+            unsigned id;
+            if (fold(n, args, id)) { ++stats.folded; return id; }
+        }
+
+        if (n.kind == NodeKind::Neg && out.nodes[args[0]].kind == NodeKind::Neg) {
+            ++stats.reduced;
+            return out.child(args[0], 0);
+        }
+        if (n.kind == NodeKind::Binary) {
+            unsigned x = args[0], y = args[1];
+            if (n.op == OpCode::POW && isLiteral(y)) {
+                if (mpf_cmp_si(value(y), 1) == 0) { ++stats.reduced; return x; }
+                if (mpf_cmp_si(value(y), 2) == 0) { ++stats.reduced; return call(FuncId::Sqr, x); }
+                if (mpf_cmp_si(value(y), -1) == 0) { ++stats.reduced; return call(FuncId::Recip, x); }
+            }
+            if (n.op == OpCode::MUL && x == y) {
+                ++stats.reduced;
+                return call(FuncId::Sqr, x);
+            }
+            if (n.op == OpCode::DIV && isLiteral(y) && mpf_sgn(value(y)) != 0) {
+                mpf_ui_div(reg[0].get_mpf_t(), 1, value(y));
+                mpf_mul(reg[1].get_mpf_t(), reg[0].get_mpf_t(), value(y));
+                if (mpf_cmp_ui(reg[1].get_mpf_t(), 1) == 0) {   // truncation only ever makes (1/y)*y smaller
+                    ++stats.reduced;
+                    return node({ NodeKind::Binary, OpCode::MUL, FuncId::Abs, x, literal(reg[0]) }, 2);
+                }
+            }
+        }
+        Key k = { n.kind, OpCode::ADD, FuncId::Abs, n.count > 0 ? args[0] : 0, n.count > 1 ? args[1] : 0 };
+        if (n.kind == NodeKind::Binary) k.op = n.op;
+        if (n.kind == NodeKind::Call) k.func = n.func;
+        return node(k, n.count);
+    }
+
+    unsigned call(FuncId f, unsigned x) {
+        return node({ NodeKind::Call, OpCode::ADD, f, x, 0 }, 1);
+    }
+
+    // Transcendental calls, factorials and powers are worth remembering across
+    // compiles: an expression typed one key at a time is compiled again on
+    // every keystroke, and its finished parts should not be computed again.
+    static bool costly(const Node& n) {
+        if (n.kind == NodeKind::Binary) return n.op == OpCode::POW;
+        if (n.kind != NodeKind::Call) return false;
+        switch (n.func) {
+        case FuncId::Abs: case FuncId::Pi: case FuncId::E: case FuncId::Sqr:
+        case FuncId::Recip: case FuncId::Mod: case FuncId::Percent:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // What the result of folding n depends on: the operation, the angle unit,
+    // the working precision and the exact operand values (sign, exponent, limbs)
+    std::string foldKey(const Node& n, const unsigned* args) const {
+        std::string key;
+        key.push_back(static_cast<char>(n.kind));
+        key.push_back(static_cast<char>(n.kind == NodeKind::Call ? static_cast<int>(n.func) : static_cast<int>(n.op)));
+        key.push_back(static_cast<char>(fold_ctx.opts.angle_unit));
+        key.append(reinterpret_cast<const char*>(&fold_ctx.prec), sizeof(fold_ctx.prec));
+        for (unsigned i = 0; i < n.count; ++i) {
+            mpf_srcptr p = value(args[i]);
+            key.append(reinterpret_cast<const char*>(&p->_mp_size), sizeof(p->_mp_size));
+            key.append(reinterpret_cast<const char*>(&p->_mp_exp), sizeof(p->_mp_exp));
+            key.append(reinterpret_cast<const char*>(p->_mp_d), sizeof(mp_limb_t) * static_cast<size_t>(std::abs(p->_mp_size)));
+        }
+        return key;
+    }
+
+    // Evaluate n on literal operands in reg[]; false (and nothing added) on an error
+    bool fold(const Node& n, const unsigned* args, unsigned& id) {
+        std::string key;
+        if (folds && costly(n)) {
+            key = foldKey(n, args);
+            if (const BigFloat* hit = folds->find(key)) {
+                ++stats.reused;
+                TRACE_COUNT("folds reused", 1);
+                id = literal(*hit);
+                return true;
+            }
+        }
+
+        mpf_ptr a = reg[0].get_mpf_t(), b = reg[1].get_mpf_t();
+        if (n.count > 0) mpf_set(a, value(args[0]));
+        if (n.count > 1) mpf_set(b, value(args[1]));
+
+        fold_ctx.error.clear();
+        fold_ctx.div0 = false;
+        switch (n.kind) {
+        case NodeKind::Neg:    mpf_neg(a, a); break;
+        case NodeKind::Binary: applyBinary(fold_ctx, n.op, a, b, scratch); break;
+        case NodeKind::Call:   callFunction(fold_ctx, n.func, reg); break;
+        default:               return false;
+        }
+        if (!fold_ctx.error.empty() || fold_ctx.div0) return false;
+        if (!key.empty()) folds->insert(key, reg[0]);
+        id = literal(reg[0]);
+        return true;
+    }
+
+    // Open-addressing table of out's nodes. Literals are keyed by value: the
+    // hash covers their limbs and mpf_cmp confirms, so a match is exact.
+    template <class Match>
+    unsigned* slot(size_t h, Match match) {
+        size_t mask = table.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask)
+            if (table[i] == NONE || match(table[i])) return &table[i];
+    }
+
+    unsigned literal(const BigFloat& v) { return literal(v.get_mpf_t(), NONE); }
+    unsigned literal(unsigned index) { return literal(out.literals[index].get_mpf_t(), index); }
+
+    // `index` names a value already in out.literals, or is NONE to add p
+    unsigned literal(mpf_srcptr p, unsigned index) {
+        size_t h = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(p->_mp_d),
+            sizeof(mp_limb_t) * static_cast<size_t>(std::abs(p->_mp_size))));
+        h ^= static_cast<size_t>(p->_mp_exp) * 1000003u;
+        unsigned* s = slot(h, [&](unsigned id) { return isLiteral(id) && mpf_cmp(value(id), p) == 0; });
+        if (*s != NONE) return *s;
+        if (index == NONE) return *s = out.literal(p);
+        Node n;
+        n.first = index;
+        out.nodes.push_back(n);
+        return *s = static_cast<unsigned>(out.nodes.size() - 1);
+    }
+
+    unsigned node(const Key& k, unsigned count) {
+        size_t h = (static_cast<size_t>(k.kind) << 16) ^ (static_cast<size_t>(k.op) << 8) ^ static_cast<size_t>(k.func);
+        h = (h * 1000003u ^ k.x) * 1000003u ^ k.y;
+        unsigned* s = slot(h, [&](unsigned id) {
+            const Node& n = out.nodes[id];
+            return n.kind == k.kind && n.op == k.op && n.func == k.func && n.count == count
+                && (count < 1 || out.child(id, 0) == k.x) && (count < 2 || out.child(id, 1) == k.y);
+        });
+        if (*s != NONE) { ++stats.shared; return *s; }
+
+        const unsigned args[2] = { k.x, k.y };
+        unsigned id = out.add(k.kind, args, count);
+        out.nodes[id].op = k.op;
+        out.nodes[id].func = k.func;
+        *s = id;
+        return id;
+    }
+
+    Ast& in;
+    Ast out;
+    EvalContext fold_ctx;   // collects errors and cancellation of the folded nodes
+    FoldCache* folds;       // results of earlier costly folds (may be null)
+    BigFloat* reg;          // two operands of a fold, laid out as callFunction expects
+    mpf_ptr scratch;
+    std::vector<unsigned> table;
+};
+
+// How many reachable parents each node has (the root counts one extra use);
+// 0 for nodes the rewrites left behind. Needs children before parents.
+static std::vector<unsigned> useCounts(const Ast& ast) {
+    std::vector<unsigned> uses(ast.nodes.size(), 0);
+    uses[ast.root] = 1;
+    for (size_t id = ast.nodes.size(); id-- > 0;) {
+        if (!uses[id]) continue;
+        for (unsigned i = 0; i < ast.nodes[id].count; ++i) ++uses[ast.child(static_cast<unsigned>(id), i)];
+    }
+    return uses;
+}
+
+// Flatten the DAG into postfix code. A node used more than once is computed
+// the first time, kept with SAVE and read back with LOAD (literals and ANS
+// are cheap enough to push again). When both sin(a) and cos(a) are needed,
+// the first one met computes both. Iterative, because a long chain such as
+// 1+1+...+1 is a tree as deep as the expression is long.
+static Program lower(Ast& ast) {
+    TRACE_SCOPE("lower");
+    const unsigned NONE = ~0u;
+    std::vector<unsigned> uses = useCounts(ast);
+
+    // partner[sin(a)] = cos(a) and the other way round
+    std::vector<unsigned> partner(ast.nodes.size(), NONE);
+    {
+        std::unordered_map<unsigned, unsigned> sin_of;   // argument -> sin node
+        for (unsigned id = 0; id < ast.nodes.size(); ++id)
+            if (uses[id] && ast.nodes[id].kind == NodeKind::Call && ast.nodes[id].func == FuncId::Sin)
+                sin_of[ast.child(id, 0)] = id;
+        for (unsigned id = 0; id < ast.nodes.size(); ++id) {
+            if (!uses[id] || ast.nodes[id].kind != NodeKind::Call || ast.nodes[id].func != FuncId::Cos) continue;
+            auto it = sin_of.find(ast.child(id, 0));
+            if (it != sin_of.end()) { partner[id] = it->second; partner[it->second] = id; }
+        }
+    }
+
+    Program prog;
+    prog.code.reserve(ast.nodes.size());
+    std::vector<unsigned> temp(ast.nodes.size(), NONE);   // where a computed node is kept
+    size_t depth = 0;
+    auto grow = [&]() { if (++depth > prog.max_depth) prog.max_depth = depth; };
+
+    std::vector<std::pair<unsigned, unsigned>> todo;   // node, children emitted so far
+    auto visit = [&](unsigned id) {
+        if (temp[id] != NONE) { prog.code.push_back({ OpCode::LOAD, temp[id] }); grow(); }
+        else todo.emplace_back(id, 0);
+    };
+    visit(ast.root);
+    while (!todo.empty()) {
+        unsigned id = todo.back().first;
+        const Node& n = ast.nodes[id];
+        if (todo.back().second < n.count) {
+            visit(ast.child(id, todo.back().second++));
+            continue;
+        }
+        todo.pop_back();
+
+        switch (n.kind) {
+        case NodeKind::Literal: prog.code.push_back({ OpCode::PUSH_CONST, n.first }); break;
+        case NodeKind::Ans:     prog.code.push_back({ OpCode::PUSH_ANS, 0 }); break;
+        case NodeKind::Neg:     prog.code.push_back({ OpCode::NEG, 0 }); break;
+        case NodeKind::Binary:  prog.code.push_back({ n.op, 0 }); break;
+        case NodeKind::Call:
+            if (partner[id] != NONE) {
+                temp[partner[id]] = prog.temps++;
+                prog.code.push_back({ n.func == FuncId::Sin ? OpCode::SINCOS : OpCode::COSSIN, temp[partner[id]] });
+            }
+            else prog.code.push_back({ OpCode::CALL, static_cast<unsigned>(n.func) });
+            break;
+        }
+        depth -= n.count;   // the children's values are replaced by one
+        grow();
+
+        if (uses[id] > 1 && n.kind != NodeKind::Literal && n.kind != NodeKind::Ans) {
+            temp[id] = prog.temps++;
+            prog.code.push_back({ OpCode::SAVE, temp[id] });
+        }
+    }
+    prog.consts = std::move(ast.literals);
+    return prog;
+}
+
+// ===== Integer tier =====
+// Subexpressions made only of integers joined by + - *, mod, non-negative
+// integer powers, abs, sqr and factorials are worked out exactly in
+// mpz_class before the optimizer sees the tree, and enter it as literals
+// rounded once to the working precision. Floating point starts only where
+// a non-integer operation does, so 1e30+1-1e30 is 1 and fact(3000)/fact(2998)
+// has no rounding error. The exact mode uses the same operations.
+
+static const size_t kMaxExactBits = 1 << 16;   // per integer, numerator or denominator
+
+// Size of n! in bits, by Stirling's formula
+static double factorialBits(unsigned long n) {
+    return std::lgamma(static_cast<double>(n) + 1.0) / std::log(2.0);
+}
+
+// v = a op b for a node whose operands are integers (b only for binary
+// nodes); false when the result is not an integer or would pass max_bits
+static bool integerOp(const Node& n, const mpz_class& a, const mpz_class& b, mpz_class& v, size_t max_bits) {
+    switch (n.kind) {
+    case NodeKind::Neg:
+        mpz_neg(v.get_mpz_t(), a.get_mpz_t());
+        return true;
+    case NodeKind::Binary:
+        switch (n.op) {
+        case OpCode::ADD: mpz_add(v.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t()); break;
+        case OpCode::SUB: mpz_sub(v.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t()); break;
+        case OpCode::MUL:
+            if (mpz_sizeinbase(a.get_mpz_t(), 2) + mpz_sizeinbase(b.get_mpz_t(), 2) > max_bits + 1) return false;
+            mpz_mul(v.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+            break;
+        case OpCode::MOD:   // sign follows the dividend, like the float path's fmod
+            if (mpz_sgn(b.get_mpz_t()) == 0) return false;
+            mpz_tdiv_r(v.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+            break;
+        case OpCode::POW: {
+            if (mpz_sgn(b.get_mpz_t()) < 0 || !mpz_fits_ulong_p(b.get_mpz_t())) return false;
+            unsigned long e = mpz_get_ui(b.get_mpz_t());
+            size_t bits = mpz_sizeinbase(a.get_mpz_t(), 2);
+            if (bits > 1 && static_cast<double>(bits - 1) * static_cast<double>(e) > static_cast<double>(max_bits)) return false;
+            mpz_pow_ui(v.get_mpz_t(), a.get_mpz_t(), e);
+            break;
+        }
+        default:
+            return false;
+        }
+        break;
+    case NodeKind::Call:
+        switch (n.func) {
+        case FuncId::Abs: mpz_abs(v.get_mpz_t(), a.get_mpz_t()); break;
+        case FuncId::Sqr:
+            if (2 * mpz_sizeinbase(a.get_mpz_t(), 2) > max_bits + 1) return false;
+            mpz_mul(v.get_mpz_t(), a.get_mpz_t(), a.get_mpz_t());
+            break;
+        case FuncId::Mod: v = a; break;
+        case FuncId::Fact:   // negative arguments are left to the float path, which gives 0
+            if (mpz_sgn(a.get_mpz_t()) < 0 || !mpz_fits_ulong_p(a.get_mpz_t())
+                || factorialBits(mpz_get_ui(a.get_mpz_t())) > static_cast<double>(max_bits)) return false;
+            mpz_fac_ui(v.get_mpz_t(), mpz_get_ui(a.get_mpz_t()));
+            break;
+        default:
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+    return mpz_sizeinbase(v.get_mpz_t(), 2) <= max_bits;
+}
+
+// "12.5", "3", ".5e-7" as a fraction; false on anything else
+static bool parseExact(const std::string& text, mpq_class& q, size_t max_bits) {
+    size_t e = text.find_first_of("eE");
+    long exp10 = 0;
+    if (e != std::string::npos) {
+        char* end = nullptr;
+        exp10 = std::strtol(text.c_str() + e + 1, &end, 10);
+        if (*end != '\0' || std::labs(exp10) > static_cast<long>(max_bits)) return false;
+    }
+    std::string digits;
+    bool seen_dot = false;
+    for (size_t i = 0; i < std::min(e, text.size()); ++i) {
+        if (text[i] == '.') {
+            if (seen_dot) return false;
+            seen_dot = true;
+        }
+        else {
+            digits.push_back(text[i]);
+            if (seen_dot) --exp10;
+        }
+    }
+    if (digits.empty()) return false;
+    // 10^k has more than 3k bits
+    if (static_cast<size_t>(std::labs(exp10)) * 3 + digits.size() * 3 > max_bits) return false;
+
+    mpz_ptr num = q.get_num_mpz_t();
+    mpz_ptr den = q.get_den_mpz_t();
+    mpz_set_str(num, digits.c_str(), 10);
+    mpz_set_ui(den, 1);
+    if (exp10 > 0) {
+        mpz_class p;
+        mpz_ui_pow_ui(p.get_mpz_t(), 10, static_cast<unsigned long>(exp10));
+        mpz_mul(num, num, p.get_mpz_t());
+    }
+    else if (exp10 < 0) {
+        mpz_ui_pow_ui(den, 10, static_cast<unsigned long>(-exp10));
+        q.canonicalize();   // the only place a literal needs it
+    }
+    return true;
+}
+
+// Whether a literal such as "12", "2.50e1" or "1e3" is an integer, from its
+// spelling alone: no more decimals than the exponent shifts away
+static bool integralSpelling(const std::string& text) {
+    size_t e = text.find_first_of("eE");
+    size_t mant_end = std::min(e, text.size());
+    size_t dot = text.find('.');
+    long decimals = 0;
+    if (dot != std::string::npos && dot < mant_end) {
+        size_t last = mant_end;
+        while (last > dot + 1 && text[last - 1] == '0') --last;   // trailing zeros do not count
+        decimals = static_cast<long>(last - dot - 1);
+    }
+    long exp10 = (e == std::string::npos) ? 0 : std::strtol(text.c_str() + e + 1, nullptr, 10);
+    return exp10 >= decimals;
+}
+
+// Whether n gives an integer when its operands are integers
+static bool integerNode(const Node& n) {
+    switch (n.kind) {
+    case NodeKind::Neg:
+        return true;
+    case NodeKind::Binary:
+        return n.op == OpCode::ADD || n.op == OpCode::SUB || n.op == OpCode::MUL
+            || n.op == OpCode::MOD || n.op == OpCode::POW;
+    case NodeKind::Call:
+        return n.func == FuncId::Abs || n.func == FuncId::Sqr || n.func == FuncId::Mod || n.func == FuncId::Fact;
+    default:
+        return false;
+    }
+}
+
+// Upper bound on the bits of an integer node's value from those of its
+// operands a and b; exact values at or past the working precision are
+// where the float path would round
+static double integerBits(const Node& n, double a, double b) {
+    switch (n.kind) {
+    case NodeKind::Binary:
+        switch (n.op) {
+        case OpCode::ADD: case OpCode::SUB: return std::max(a, b) + 1;
+        case OpCode::MUL: return a + b;
+        case OpCode::MOD: return b;
+        case OpCode::POW: return a <= 1 ? 1 : std::ldexp(a, static_cast<int>(std::min(b, 1024.0)));   // exponent below 2^b
+        default: return a;
+        }
+    case NodeKind::Call:
+        if (n.func == FuncId::Sqr) return 2 * a;
+        if (n.func == FuncId::Fact) return a < 64 ? factorialBits(static_cast<unsigned long>(std::ldexp(1.0, static_cast<int>(a)))) : HUGE_VAL;
+        return a;
+    default:
+        return a;
+    }
+}
+
+// Replace each integer subexpression of the parsed tree by a literal of its
+// exact value at the working precision. Nodes keep their place, so their
+// parents still find them; the children of a replaced node go unused.
+static void foldIntegers(EvalContext& ctx, Ast& ast, const std::vector<std::string>& spellings) {
+    struct Shape {
+        double bits;   // upper bound on the size of the value
+        char is_int;   // integer operands and operation, so far as known
+        char exact;    // worked out in mpz_class
+    };
+    // first by the shape of the tree and the size of its literals, which
+    // rules out most expressions: integers that fit the working precision
+    // come out of the float path exactly too, and mod is done in doubles
+    const size_t n = ast.nodes.size();
+    const double limit = static_cast<double>(ctx.prec) - 1;
+    std::vector<Shape> shape(n, Shape{ 0, 0, 0 });
+    size_t candidates = 0;
+    for (unsigned id = 0; id < n; ++id) {   // children come before their parents
+        const Node& node = ast.nodes[id];
+        Shape& s = shape[id];
+        if (node.kind == NodeKind::Literal) {
+            s.is_int = integralSpelling(spellings[node.first]);
+            long exp = 0;
+            mpf_get_d_2exp(&exp, ast.literals[node.first].get_mpf_t());
+            s.bits = static_cast<double>(std::max(exp, 0L));
+            s.exact = s.bits > limit;
+        }
+        else if (integerNode(node)) {
+            const Shape& a = shape[ast.child(id, 0)];
+            const Shape& b = shape[ast.child(id, node.count - 1)];
+            s.is_int = a.is_int && b.is_int;
+            s.bits = integerBits(node, a.bits, b.bits);
+            s.exact = a.exact || b.exact || s.bits > limit
+                || (node.kind == NodeKind::Binary && node.op == OpCode::MOD && std::max(a.bits, b.bits) > 53);
+            candidates += s.is_int && s.exact;
+        }
+    }
+    if (candidates == 0) return;
+
+    // the operands of an exact node are exact as well
+    for (unsigned id = static_cast<unsigned>(n); id-- > 0;) {
+        const Node& node = ast.nodes[id];
+        if (!shape[id].is_int || !shape[id].exact || node.kind == NodeKind::Literal) continue;
+        for (unsigned i = 0; i < node.count; ++i) shape[ast.child(id, i)].exact = 1;
+    }
+
+    // then exactly, reading only the literals an integer operation uses
+    std::vector<mpz_class> ints(n);
+    std::vector<char> parsed(n, 0);
+    auto operand = [&](unsigned id) {
+        const Node& node = ast.nodes[id];
+        if (node.kind != NodeKind::Literal || parsed[id]) return shape[id].is_int != 0;
+        parsed[id] = 1;
+        const std::string& text = spellings[node.first];
+        char& ok = shape[id].is_int;
+        if (text.find_first_not_of("0123456789") == std::string::npos)
+            ok = text.size() * 3 <= kMaxExactBits && mpz_set_str(ints[id].get_mpz_t(), text.c_str(), 10) == 0;
+        else {   // "2.5e1" and the like
+            mpq_class q;
+            ok = parseExact(text, q, kMaxExactBits);
+            if (ok) mpz_swap(ints[id].get_mpz_t(), q.get_num_mpz_t());
+        }
+        return ok != 0;
+    };
+    size_t folded = 0;
+    for (unsigned id = 0; id < n; ++id) {
+        const Node& node = ast.nodes[id];
+        Shape& s = shape[id];
+        if (!s.is_int || !s.exact || node.kind == NodeKind::Literal) continue;
+        unsigned a = ast.child(id, 0), b = ast.child(id, node.count - 1);
+        poll(ctx);
+        s.is_int = operand(a) && operand(b) && integerOp(node, ints[a], ints[b], ints[id], kMaxExactBits);
+        folded += s.is_int;
+    }
+    if (folded == 0) return;
+
+    ast.literals.reserve(ast.literals.size() + folded);   // no more than Parser reserved: one value per token
+    for (unsigned id = 0; id < n; ++id) {
+        Node& node = ast.nodes[id];
+        if (!shape[id].is_int || !shape[id].exact || node.kind == NodeKind::Literal) continue;
+        node.kind = NodeKind::Literal;
+        node.first = static_cast<unsigned>(ast.literals.size());
+        node.count = 0;
+        ast.literals.emplace_back(0, ctx.prec);
+        mpf_set_z(ast.literals.back().get_mpf_t(), ints[id].get_mpz_t());
+    }
+}
+
+static Program compileTokens(EvalContext& ctx, const Token* first, const Token* last) {
+    Ast parsed;
+    std::vector<std::string> spellings;
+    Parser parser(first, last, ctx.prec, parsed);
+    parser.keepSpellings(spellings);
+    parser.parse();
+    foldIntegers(ctx, parsed, spellings);
+
+    Optimizer opt(ctx, parsed);
+    Ast ast = opt.run();
+    if (ctx.opts.dump_optimizer) {
+        std::vector<unsigned> uses = useCounts(ast);
+        opt.stats.after = static_cast<size_t>(std::count_if(uses.begin(), uses.end(), [](unsigned u) { return u > 0; }));
+        std::string expr;
+        for (const Token* t = first; t != last; ++t) {
+            if (t != first) expr.push_back(' ');
+            expr += t->spelling();
+        }
+        std::fprintf(stderr, "optimizer: %zu -> %zu nodes (%u folded, %u reused, %u shared, %u reduced) at %lu bits: %s\n",
+            opt.stats.before, opt.stats.after, opt.stats.folded, opt.stats.reused, opt.stats.shared, opt.stats.reduced,
+            static_cast<unsigned long>(ctx.prec), expr.c_str());
+    }
+
+    Program prog = lower(ast);
+    prog.lost_bits = opt.lostBits();
+    return prog;
+}
+
+static std::string cacheKey(const EvalContext& ctx, const Token* first, const Token* last) {
+    std::string key;
+    key.reserve(static_cast<size_t>(last - first) + 16);
+    for (const Token* t = first; t != last; ++t) {
+        switch (t->kind) {
+        case TokenKind::Number:   key += t->text; break;
+        case TokenKind::Operator: key.push_back(t->op); break;
+        case TokenKind::LParen:   key.push_back('('); break;
+        case TokenKind::RParen:   key.push_back(')'); break;
+        case TokenKind::Comma:    key.push_back(','); break;
+        case TokenKind::Ans:      key.push_back('A'); break;
+        case TokenKind::Function:
+            key.push_back('#');
+            key.push_back(static_cast<char>('a' + static_cast<int>(t->func)));
+            break;
+        default:                  key.push_back('?'); break;   // does not parse, never cached
+        }
+    }
+    key.push_back('|');
+    key += std::to_string(static_cast<int>(ctx.opts.angle_unit));
+    key.push_back('|');
+    key += std::to_string(ctx.prec);
+    return key;
+}
+
+static std::shared_ptr<const Program> compileCached(EvalContext& ctx, const Token* first, const Token* last) {
+    if (!ctx.cache) return std::make_shared<const Program>(compileTokens(ctx, first, last));
+
+    std::string key = cacheKey(ctx, first, last);
+    if (auto hit = ctx.cache->find(key)) {
+        TRACE_COUNT("program cache hits", 1);
+        return *hit;
+    }
+    TRACE_COUNT("program cache misses", 1);
+
+    auto prog = std::make_shared<const Program>(compileTokens(ctx, first, last));
+    ctx.cache->insert(key, prog);
+    return prog;
+}
+
+static BigFloat evaluateTokens(EvalContext& ctx, const std::vector<Token>& toks) {
+    const Token* first = toks.data();
+    return runProgram(ctx, *compileCached(ctx, first, first + toks.size()));
+}
+
+// ===== Exact rational mode =====
+// With EvalOptions::exact the tree is first evaluated in mpq_class. Only the
+// operations that keep a rational exact take part: + - * /, integer powers,
+// unary minus, abs, sqr, recip, percent, the FUNC_MOD grouping, and mod and
+// factorials of integers through integerOp(). Anything
+// else, a division by zero or a fraction past kMaxExactBits makes
+// runExact() give up, and the expression is evaluated in floating point
+// as usual, which also reports the error.
+
+// Worth parsing at all: no transcendental call
+static bool mayBeRational(const std::vector<Token>& tokens) {
+    for (const Token& t : tokens) {
+        if (t.kind != TokenKind::Function) continue;
+        switch (t.func) {
+        case FuncId::Abs: case FuncId::Sqr: case FuncId::Recip: case FuncId::Percent: case FuncId::Mod:
+        case FuncId::Fact:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool fitsExact(const mpq_class& q, size_t max_bits) {
+    return mpz_sizeinbase(q.get_num_mpz_t(), 2) <= max_bits && mpz_sizeinbase(q.get_den_mpz_t(), 2) <= max_bits;
+}
+
+// q = q^n. A canonical fraction raised to a power stays canonical, so the
+// numerator and denominator are powered separately.
+static bool powExact(mpq_class& q, const mpq_class& n, size_t max_bits) {
+    if (mpz_cmp_ui(n.get_den_mpz_t(), 1) != 0 || !mpz_fits_slong_p(n.get_num_mpz_t())) return false;
+    long k = mpz_get_si(n.get_num_mpz_t());
+    if (q == 0) {
+        if (k < 0) return false;   // "undefined", reported by the float path
+        if (k == 0) q = 1;
+        return true;
+    }
+    unsigned long m = static_cast<unsigned long>(k < 0 ? -k : k);
+    size_t bits = std::max(mpz_sizeinbase(q.get_num_mpz_t(), 2), mpz_sizeinbase(q.get_den_mpz_t(), 2));
+    if (bits > 1 && static_cast<double>(bits - 1) * static_cast<double>(m) > static_cast<double>(max_bits)) return false;
+
+    mpz_pow_ui(q.get_num_mpz_t(), q.get_num_mpz_t(), m);
+    mpz_pow_ui(q.get_den_mpz_t(), q.get_den_mpz_t(), m);
+    if (k < 0) {
+        mpz_swap(q.get_num_mpz_t(), q.get_den_mpz_t());
+        if (mpz_sgn(q.get_den_mpz_t()) < 0) {   // keep the sign on the numerator
+            mpz_neg(q.get_num_mpz_t(), q.get_num_mpz_t());
+            mpz_neg(q.get_den_mpz_t(), q.get_den_mpz_t());
+        }
+    }
+    return true;
+}
+
+// The parsed tree with its literals as fractions. Without ANS the value
+// never changes, so it is worked out once when the program is cached.
+struct ExactProgram {
+    Ast tree;                          // nodes and kids only
+    std::vector<mpq_class> literals;   // indexed like Ast::literals
+    bool folded = false;               // `value` is the result
+    mpq_class value;
+};
+
+static bool runExact(EvalContext& ctx, const ExactProgram& prog, size_t max_bits,
+    std::vector<mpq_class>& vals, mpq_class& out);
+
+// Exact programs by cacheKey(); null for expressions that cannot be evaluated
+// exactly, so those go straight to the float path the next time
+class ExactCache : public LruCache<std::shared_ptr<const ExactProgram>> {
+public:
+    using LruCache::LruCache;
+};
+
+static std::shared_ptr<ExactProgram> compileExact(const std::vector<Token>& tokens) {
+    auto prog = std::make_shared<ExactProgram>();
+    std::vector<std::string> spellings;
+    Parser parser(tokens.data(), tokens.data() + tokens.size(), 64, prog->tree);
+    parser.keepSpellings(spellings);
+    try {
+        parser.parse();
+    }
+    catch (const std::invalid_argument&) { return nullptr; }   // the float path reports it
+    prog->tree.literals.clear();
+
+    prog->literals.resize(spellings.size());
+    for (size_t i = 0; i < spellings.size(); ++i)
+        if (!parseExact(spellings[i], prog->literals[i], kMaxExactBits)) return nullptr;
+    return prog;
+}
+
+static std::shared_ptr<const ExactProgram> compileExactCached(EvalContext& ctx, ExactCache* cache,
+    const std::vector<Token>& tokens)
+{
+    if (!mayBeRational(tokens)) return nullptr;
+    if (!cache) return compileExact(tokens);
+
+    std::string key = cacheKey(ctx, tokens.data(), tokens.data() + tokens.size());
+    if (auto hit = cache->find(key)) return *hit;
+    std::shared_ptr<ExactProgram> prog = compileExact(tokens);
+    if (prog && std::none_of(prog->tree.nodes.begin(), prog->tree.nodes.end(),
+        [](const Node& n) { return n.kind == NodeKind::Ans; })) {
+        if (runExact(ctx, *prog, kMaxExactBits, ctx.stack.fractions(), prog->value)) prog->folded = true;
+        else prog = nullptr;
+    }
+    cache->insert(key, prog);
+    return prog;
+}
+
+// v = a op b through the integer tier, for integer operands only
+static bool integerExact(const Node& n, const mpq_class& a, const mpq_class& b, mpq_class& v, size_t max_bits) {
+    if (mpz_cmp_ui(a.get_den_mpz_t(), 1) != 0 || mpz_cmp_ui(b.get_den_mpz_t(), 1) != 0) return false;
+    if (!integerOp(n, a.get_num(), b.get_num(), v.get_num(), max_bits)) return false;
+    mpz_set_ui(v.get_den_mpz_t(), 1);
+    return true;
+}
+
+// The exact value of prog, or false to evaluate it in floating point.
+// `vals` is scratch, one value per node, kept by the caller between runs.
+static bool runExact(EvalContext& ctx, const ExactProgram& prog, size_t max_bits,
+    std::vector<mpq_class>& vals, mpq_class& out)
+{
+    TRACE_SCOPE("exact");
+    if (prog.folded) {
+        out = prog.value;
+        return fitsExact(out, max_bits);
+    }
+    const Ast& ast = prog.tree;
+    if (vals.size() < ast.nodes.size()) vals.resize(ast.nodes.size());
+    for (unsigned id = 0; id < ast.nodes.size(); ++id) {   // children come before their parents
+        poll(ctx);
+        const Node& n = ast.nodes[id];
+        mpq_class& v = vals[id];
+        switch (n.kind) {
+        case NodeKind::Literal:
+            v = prog.literals[n.first];
+            break;
+        case NodeKind::Ans:
+            if (!ctx.opts.ans_is_exact) return false;
+            v = ctx.opts.exact_ans;
+            break;
+        case NodeKind::Neg:
+            mpq_neg(v.get_mpq_t(), vals[ast.child(id, 0)].get_mpq_t());
+            break;
+        case NodeKind::Binary: {
+            const mpq_class& a = vals[ast.child(id, 0)];
+            const mpq_class& b = vals[ast.child(id, 1)];
+            switch (n.op) {
+            case OpCode::ADD: mpq_add(v.get_mpq_t(), a.get_mpq_t(), b.get_mpq_t()); break;
+            case OpCode::SUB: mpq_sub(v.get_mpq_t(), a.get_mpq_t(), b.get_mpq_t()); break;
+            case OpCode::MUL: mpq_mul(v.get_mpq_t(), a.get_mpq_t(), b.get_mpq_t()); break;
+            case OpCode::DIV:
+                if (b == 0) return false;
+                mpq_div(v.get_mpq_t(), a.get_mpq_t(), b.get_mpq_t());
+                break;
+            case OpCode::POW:
+                v = a;
+                if (!powExact(v, b, max_bits)) return false;
+                break;
+            case OpCode::MOD:
+                if (!integerExact(n, a, b, v, max_bits)) return false;
+                break;
+            default:
+                return false;
+            }
+            break;
+        }
+        case NodeKind::Call: {
+            const mpq_class& a = vals[ast.child(id, 0)];
+            switch (n.func) {
+            case FuncId::Abs:     mpq_abs(v.get_mpq_t(), a.get_mpq_t()); break;
+            case FuncId::Sqr:     mpq_mul(v.get_mpq_t(), a.get_mpq_t(), a.get_mpq_t()); break;
+            case FuncId::Percent: mpq_div(v.get_mpq_t(), a.get_mpq_t(), mpq_class(100).get_mpq_t()); break;
+            case FuncId::Mod:     v = a; break;
+            case FuncId::Recip:
+                if (a == 0) return false;
+                mpq_inv(v.get_mpq_t(), a.get_mpq_t());
+                break;
+            case FuncId::Fact:
+                if (!integerExact(n, a, a, v, max_bits)) return false;
+                break;
+            default:
+                return false;
+            }
+            break;
+        }
+        }
+        if (!fitsExact(v, max_bits)) return false;
+    }
+    out = vals[ast.root];
+    return true;
+}
+
+// ===== Formatting =====
+// Every form is cut from the digits of one DecimalForm conversion.
+
+// Round a digit-only mantissa to `keep` significant digits (half-up), with carry propagation.
+static void round_digit_mantissa(std::string& d, int keep) {
+    if ((int)d.size() <= keep) return;
+    int carry = (d[keep] >= '5') ? 1 : 0;
+    d.resize(keep);
+    for (int i = keep - 1; i >= 0 && carry; --i) {
+        int v = (d[i] - '0') + carry;
+        d[i] = char('0' + (v % 10));
+        carry = v / 10;
+    }
+    if (carry) d.insert(d.begin(), '1'); // e.g., 9..9 -> 10..0, bumps exponent
+}
+
+// Digits 0.mant × 10^exp written out with the decimal point in place
+static std::string place_point(bool neg, const std::string& mant, long exp) {
+    std::string s;
+    if (exp <= 0) {
+        s += neg ? "-0." : "0.";
+        s.append(static_cast<size_t>(-exp), '0');
+        s += mant;
+    }
+    else if (static_cast<size_t>(exp) >= mant.size()) {
+        s += neg ? "-" : "";
+        s += mant;
+        s.append(static_cast<size_t>(exp) - mant.size(), '0');
+    }
+    else {
+        s += neg ? "-" : "";
+        s.append(mant, 0, static_cast<size_t>(exp));
+        s.push_back('.');
+        s.append(mant, static_cast<size_t>(exp), std::string::npos);
+    }
+    return s;
+}
+
+static std::string format_fixed(bool neg, const std::string& mant, long exp, int max_decimals) {
+    // long mantissa from the caller, cut to max_decimals in fixed form
+    if (mant.empty()) return "0";
+    std::string s = place_point(neg, mant, exp);
+
+    // round/cut to max_decimals
+    auto dot = s.find('.');
+    if (dot != std::string::npos) {
+        size_t want = dot + 1 + static_cast<size_t>(max_decimals);
+        if (s.size() > want) {
+            // simple cut (optional: implement half-up rounding)
+            s.resize(want);
+        }
+        // trim trailing zeros
+        while (!s.empty() && s.back() == '0') s.pop_back();
+        if (!s.empty() && s.back() == '.') s.pop_back();
+    }
+    return s.empty() ? "0" : s;
+}
+
+static std::string format_scientific_e(bool neg, const std::string& mant, long exp10, int sig_digits) {
+    // mant like "12345..." with exp10 meaning 1.2345... × 10^(exp10-1)
+    std::string m = mant;
+    if (m.size() > 1) {
+        m.insert(m.begin() + 1, '.');  // 1.xxx
+    }
+
+    // trim decimals to sig_digits total significant figures
+    if (auto p = m.find('.'); p != std::string::npos) {
+        // keep: 1 digit, '.', and (sig_digits - 1) decimal digits
+        size_t keep = 1 + 1 + (sig_digits - 1);
+        if (m.size() > keep) m.resize(keep);
+
+        // strip trailing zeros and possible trailing '.'
+        while (!m.empty() && m.back() == '0') m.pop_back();
+        if (!m.empty() && m.back() == '.') m.pop_back();
+    }
+
+    long e = exp10 - 1;
+
+    std::string out;
+    if (neg) out.push_back('-');
+    out += m;
+    out += 'e';
+    if (e >= 0) out.push_back('+');
+    out += std::to_string(e);
+
+    return out;
+}
+
+static std::string shrink_for_display(const std::string& s, std::size_t max_chars = 24)
+{
+    if (s.size() <= max_chars) return s;
+
+    // Look for scientific 'e' notation
+    std::size_t epos = s.find('e');
+    if (epos == std::string::npos) {
+        // Not scientific: just hard truncate from the right
+        return s.substr(0, max_chars);
+    }
+
+    // Split into mantissa (with sign) and exponent
+    std::string mant = s.substr(0, epos);   // e.g. "-1.23456789"
+    std::string exp = s.substr(epos);      // e.g. "e+12345"
+
+    // While the whole thing is too long, try to drop fractional digits
+    while (mant.size() + exp.size() > max_chars) {
+        // Find decimal point in mantissa
+        std::size_t dot = mant.find('.');
+        if (dot == std::string::npos) {
+            // No decimal point → nothing fractional to drop
+            break;
+        }
+        if (mant.size() <= dot + 1) {
+            // Nothing after "." to drop
+            break;
+        }
+
+        // Drop one character from the end (a fractional digit)
+        mant.pop_back();
+
+        // Clean up trailing zeros and possibly the '.' itself
+        while (!mant.empty() && mant.back() == '0') mant.pop_back();
+        if (!mant.empty() && mant.back() == '.') mant.pop_back();
+    }
+
+    std::string out = mant + exp;
+
+    // As a last resort (huge exponents), just hard truncate
+    if (out.size() > max_chars)
+        out.resize(max_chars);
+
+    return out;
+}
+
+DecimalForm::DecimalForm(const mpf_class& x, size_t digits)
+    : value(x, x.get_prec()), ndigits(std::max(digits, kDisplayDigits))
+{
+    TRACE_SCOPE("format");
+    mp_exp_t e = 0;
+    mant = x.get_str(e, 10, ndigits);
+    exp10 = static_cast<long>(e);
+    neg = (!mant.empty() && mant[0] == '-');
+    if (neg) mant.erase(mant.begin());
+}
+
+// What get_str(exp, 10, keep) gives. The cached digits are themselves
+// rounded, so when all they have past `keep` is a single 5 the value may lie
+// on either side of the halfway point and only a fresh conversion can tell.
+std::string DecimalForm::rounded(size_t keep, long& exp) const {
+    if (keep > 0 && mant.size() == keep + 1 && mant[keep] == '5') {
+        mp_exp_t e = 0;
+        std::string d = value.get_str(e, 10, keep);
+        if (!d.empty() && d[0] == '-') d.erase(d.begin());
+        exp = static_cast<long>(e);
+        return d;
+    }
+
+    std::string d = mant;
+    exp = exp10;
+    if (keep > 0 && d.size() > keep) {
+        round_digit_mantissa(d, static_cast<int>(keep));
+        if (d.size() > keep) {   // carried into a new leading digit
+            d.resize(keep);
+            ++exp;
+        }
+        while (!d.empty() && d.back() == '0') d.pop_back();
+    }
+    return d;
+}
+
+std::string DecimalForm::display(int max_decimals,
+    int sci_sig,
+    int sci_pos_thresh,
+    int sci_neg_thresh) const
+{
+    if (mant.empty()) return "0";
+    long e = 0;
+    (void)rounded(2, e);
+    long exp10_disp = e - 1;
+
+    std::string s;
+    if (exp10_disp >= sci_pos_thresh || exp10_disp <= sci_neg_thresh) {
+        // e-notation
+        std::string m = rounded(static_cast<size_t>(sci_sig) + 2, e); // a little headroom
+        s = format_scientific_e(neg, m, e, sci_sig);
+    }
+    else {
+        // fixed notation
+        s = format_fixed(neg, mant, exp10, max_decimals);
+    }
+
+    // Enforce max display width (24 chars)
+    return shrink_for_display(s, 24);
+}
+
+std::string DecimalForm::plain(size_t digits) const {
+    long e = 0;
+    std::string m = rounded(std::min(digits, ndigits), e);
+    if (m.empty()) return "0";
+
+    // 2^(10^12) would take 3e11 characters written out; once the zeros to pad
+    // with outnumber the digits, e-notation keeps the string within 2 × digits
+    long pad = e > 0 ? e - static_cast<long>(m.size()) : -e;
+    if (pad > static_cast<long>(std::min(digits, ndigits)))
+        return format_scientific_e(neg, m, e, static_cast<int>(m.size()));
+
+    std::string s = place_point(neg, m, e);
+    if (auto p = s.find('.'); p != std::string::npos) {
+        while (!s.empty() && s.back() == '0') s.pop_back();
+        if (!s.empty() && s.back() == '.') s.pop_back();
+    }
+    return s.empty() ? "0" : s;
+}
+
+std::string format_for_display(const mpf_class& x,
+    int max_decimals,
+    int sci_sig,
+    int sci_pos_thresh,
+    int sci_neg_thresh)
+{
+    if (x == 0) return "0";
+    return DecimalForm(x).display(max_decimals, sci_sig, sci_pos_thresh, sci_neg_thresh);
+}
+
+// GMP string formatter (no iostream precision quirks)
+std::string mpf_to_string(const mpf_class& x, size_t digits) {
+    return DecimalForm(x, digits).plain(digits);
+}
+
+std::string format_exact(const mpq_class& q) {
+    mpz_srcptr num = q.get_num_mpz_t();
+    mpz_srcptr den = q.get_den_mpz_t();
+    if (mpz_cmp_ui(den, 1) == 0) return q.get_num().get_str();
+
+    // terminates when the denominator is 2^a 5^b; then q = n / 10^max(a, b)
+    mpz_class rest;
+    unsigned long twos = mpz_remove(rest.get_mpz_t(), den, mpz_class(2).get_mpz_t());
+    unsigned long fives = mpz_remove(rest.get_mpz_t(), rest.get_mpz_t(), mpz_class(5).get_mpz_t());
+    if (rest != 1) return q.get_str();
+
+    unsigned long k = std::max(twos, fives);
+    mpz_class n;
+    mpz_ui_pow_ui(n.get_mpz_t(), 10, k);
+    mpz_mul(n.get_mpz_t(), n.get_mpz_t(), num);
+    mpz_divexact(n.get_mpz_t(), n.get_mpz_t(), den);
+    mpz_abs(n.get_mpz_t(), n.get_mpz_t());
+
+    std::string digits = n.get_str();
+    if (digits.size() <= k) digits.insert(0, k + 1 - digits.size(), '0');
+    digits.insert(digits.size() - k, 1, '.');
+    return (mpz_sgn(num) < 0 ? "-" : "") + digits;
+}
+
+bool parse_exact(const std::string& text, mpq_class& q) {
+    size_t start = (!text.empty() && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+    size_t e = std::min(text.find_first_of("eE"), text.size());
+    for (size_t i = start; i < e; ++i)   // parseExact trusts the lexer for this
+        if (!std::isdigit(static_cast<unsigned char>(text[i])) && text[i] != '.') return false;
+    if (!parseExact(text.substr(start), q, kMaxExactBits)) return false;
+    if (text[0] == '-') q = -q;
+    return true;
+}
+
+// ===== Tokens =====
+
+// GUI spelling of each FuncId, in enum order
+static const char* const kFuncTokens[] = {
+    "FUNC_ABS", "FUNC_PI", "FUNC_E",
+    "FUNC_SIN", "FUNC_COS", "FUNC_TAN", "FUNC_ASIN", "FUNC_ACOS", "FUNC_ATAN",
+    "FUNC_SINH", "FUNC_COSH", "FUNC_TANH", "FUNC_ASINH", "FUNC_ACOSH", "FUNC_ATANH",
+    "FUNC_LN", "FUNC_LOG10", "FUNC_SQRT", "FUNC_SQR", "FUNC_RECIP", "FUNC_EXP", "FUNC_EXP10",
+    "FUNC_FACT", "FUNC_MOD", "FUNC_PERCENT", "FUNC_XROOT",
+};
+
+// Operators of the Programmer view (wordint.h); the float Parser rejects them
+static const struct { char op; const char* spelling; } kWordOperators[] = {
+    { '&', "AND" }, { '|', "OR" }, { 'x', "XOR" }, { '<', "LSH" }, { '>', "RSH" }, { '~', "NOT" },
+};
+
+static bool isNumberSpelling(const std::string& s) {
+    if (s.empty()) return false;
+    for (char c : s)
+        if (!std::isdigit(static_cast<unsigned char>(c)) && c != '.') return false;
+    return true;
+}
+
+Token::Token(const char* spelling) : Token(std::string(spelling)) {}
+
+Token::Token(const std::string& spelling) {
+    if (spelling.size() == 1) {
+        switch (spelling[0]) {
+        case '(': kind = TokenKind::LParen; return;
+        case ')': kind = TokenKind::RParen; return;
+        case ',': kind = TokenKind::Comma; return;
+        case '+': case '-': case '*': case '/': case '^':
+            kind = TokenKind::Operator; op = spelling[0]; return;
+        default: break;
+        }
+    }
+    if (spelling == "mod") { kind = TokenKind::Operator; op = '%'; return; }
+    for (const auto& w : kWordOperators)
+        if (spelling == w.spelling) { kind = TokenKind::Operator; op = w.op; return; }
+    if (spelling == "ANS") { kind = TokenKind::Ans; return; }
+    if (isNumberSpelling(spelling)) { kind = TokenKind::Number; text = spelling; return; }
+    if (spelling.rfind("FUNC_", 0) == 0) {
+        for (size_t i = 0; i < sizeof(kFuncTokens) / sizeof(kFuncTokens[0]); ++i) {
+            if (spelling == kFuncTokens[i]) {
+                kind = TokenKind::Function;
+                func = static_cast<FuncId>(i);
+                return;
+            }
+        }
+    }
+    text = spelling;   // Identifier
+}
+
+Token Token::number(std::string digits) {
+    Token t;
+    t.kind = TokenKind::Number;
+    t.text = std::move(digits);
+    return t;
+}
+
+Token Token::oper(char op) {
+    Token t;
+    t.kind = TokenKind::Operator;
+    t.op = op;
+    return t;
+}
+
+Token Token::function(FuncId f) {
+    Token t;
+    t.kind = TokenKind::Function;
+    t.func = f;
+    return t;
+}
+
+std::string Token::spelling() const {
+    switch (kind) {
+    case TokenKind::Number:   return text;
+    case TokenKind::Operator:
+        if (op == '%') return "mod";
+        for (const auto& w : kWordOperators)
+            if (op == w.op) return w.spelling;
+        return std::string(1, op);
+    case TokenKind::LParen:   return "(";
+    case TokenKind::RParen:   return ")";
+    case TokenKind::Comma:    return ",";
+    case TokenKind::Function: return kFuncTokens[static_cast<size_t>(func)];
+    case TokenKind::Ans:      return "ANS";
+    default:                  return text;
+    }
+}
+
+// ===== Text front end =====
+
+// Short names accepted in text input, mapped to the GUI's function tokens
+static std::string canonicalIdentifier(const std::string& id) {
+    std::string up;
+    for (char c : id) up.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+
+    if (up == "ANS") return "ANS";
+    if (up == "MOD") return "mod";
+    if (up.rfind("FUNC_", 0) == 0) return up;
+
+    static const char* const aliases[][2] = {
+        { "ABS", "FUNC_ABS" },     { "PI", "FUNC_PI" },         { "E", "FUNC_E" },
+        { "SIN", "FUNC_SIN" },     { "COS", "FUNC_COS" },       { "TAN", "FUNC_TAN" },
+        { "ASIN", "FUNC_ASIN" },   { "ACOS", "FUNC_ACOS" },     { "ATAN", "FUNC_ATAN" },
+        { "SINH", "FUNC_SINH" },   { "COSH", "FUNC_COSH" },     { "TANH", "FUNC_TANH" },
+        { "ASINH", "FUNC_ASINH" }, { "ACOSH", "FUNC_ACOSH" },   { "ATANH", "FUNC_ATANH" },
+        { "LN", "FUNC_LN" },       { "LOG", "FUNC_LOG10" },     { "LOG10", "FUNC_LOG10" },
+        { "SQRT", "FUNC_SQRT" },   { "SQR", "FUNC_SQR" },       { "RECIP", "FUNC_RECIP" },
+        { "EXP", "FUNC_EXP" },     { "EXP10", "FUNC_EXP10" },   { "FACT", "FUNC_FACT" },
+        { "PERCENT", "FUNC_PERCENT" }, { "XROOT", "FUNC_XROOT" },
+    };
+    for (const auto& a : aliases)
+        if (up == a[0]) return a[1];
+    return up;   // unknown identifiers are rejected by the parser
+}
+
+std::vector<Token> tokenize(std::string_view s) {
+    TRACE_SCOPE("tokenize");
+    std::vector<Token> out;
+    const size_t n = s.size();
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (std::isspace(c)) continue;
+
+        if (std::isdigit(c) || c == '.') {
+            size_t j = i;
+            while (j < n && (std::isdigit(static_cast<unsigned char>(s[j])) || s[j] == '.')) ++j;
+            // exponent: "1e30", "2.5E-3"; a bare "2e" is still 2 times e
+            if (j < n && (s[j] == 'e' || s[j] == 'E')) {
+                size_t k = j + 1;
+                if (k < n && (s[k] == '+' || s[k] == '-')) ++k;
+                if (k < n && std::isdigit(static_cast<unsigned char>(s[k]))) {
+                    while (k < n && std::isdigit(static_cast<unsigned char>(s[k]))) ++k;
+                    j = k;
+                }
+            }
+            out.push_back(Token::number(std::string(s.substr(i, j - i))));
+            i = j - 1;
+        }
+        else if (std::isalpha(c) || c == '_') {
+            size_t j = i;
+            while (j < n && (std::isalnum(static_cast<unsigned char>(s[j])) || s[j] == '_')) ++j;
+            Token t = canonicalIdentifier(std::string(s.substr(i, j - i)));
+            if (t.kind == TokenKind::Identifier) {
+                // unknown name: digits after it are a number of their own ("7mod2")
+                size_t k = i;
+                while (k < j && (std::isalpha(static_cast<unsigned char>(s[k])) || s[k] == '_')) ++k;
+                if (k < j) { j = k; t = canonicalIdentifier(std::string(s.substr(i, j - i))); }
+            }
+            out.push_back(std::move(t));
+            i = j - 1;
+        }
+        else {
+            out.emplace_back(std::string(1, static_cast<char>(c)));
+        }
+    }
+    return out;
+}
+
+// ===== Engine =====
+
+Engine::Engine(size_t cache_capacity)
+    : cache(new ProgramCache(cache_capacity))
+    , folds(cache_capacity ? new FoldCache(kFoldCacheCapacity) : nullptr)
+    , exacts(new ExactCache(cache_capacity))
+    , stack(new EvalStack())
+{
+}
+
+Engine::~Engine() = default;
+
+CacheStats Engine::cacheStats() const {
+    return cache->stats();
+}
+
+void Engine::clearCache() {
+    cache->clear();
+    exacts->clear();
+    if (folds) folds->clear();
+}
+
+EvalResult Engine::evaluate(std::string_view expr, const EvalOptions& opts) {
+    return evaluate(tokenize(expr), opts);
+}
+
+// ===== Precision policy =====
+// Each evaluation starts at the precision needed for opts.digits plus guard
+// bits. If an addition or subtraction cancelled so many leading bits that the
+// guard is used up, the evaluation is repeated at a higher precision (Ziv's
+// strategy) until the leading opts.digits digits agree between two attempts,
+// or the ceiling is reached. The ceiling is the old fixed 8192-bit default.
+
+static const mp_bitcnt_t kGuardBits = 64;
+static const mp_bitcnt_t kMaxAdaptivePrecision = 8192;
+
+static mp_bitcnt_t bitsForDigits(unsigned digits) {
+    return static_cast<mp_bitcnt_t>(std::ceil(digits * 3.3219280948873623));   // log2(10)
+}
+
+// Leading `digits` significant digits plus exponent, for comparing attempts
+static std::string leadingDigits(const BigFloat& x, unsigned digits) {
+    mp_exp_t exp = 0;
+    std::string s = x.get_str(exp, 10, digits);
+    s.push_back('e');
+    s += std::to_string(exp);
+    return s;
+}
+
+// ===== Budgets =====
+// Limb storage of one value at `prec` bits: mpf keeps a limb more than the
+// precision needs, and the allocation has one more for rounding
+static size_t valueBytes(mp_bitcnt_t prec) {
+    return (static_cast<size_t>(prec / GMP_NUMB_BITS) + 3) * sizeof(mp_limb_t);
+}
+
+// Upper estimate of the values an expression of n tokens holds at once:
+// parsed literals, folded constants, interpreter slots and temps
+static size_t valuesHeld(size_t n_tokens) {
+    return 2 * n_tokens + 4;
+}
+
+// The result's decimal strings: DecimalForm's digits and a plain() form,
+// which is at most twice as long
+static size_t outputBytes(const EvalOptions& opts) {
+    return 3 * std::max<size_t>(opts.digits, DecimalForm::kDisplayDigits) + 64;
+}
+
+// Largest precision whose values, and the output, fit in opts.memory_limit
+// (unlimited: ~0)
+static mp_bitcnt_t maxPrecisionFor(const EvalOptions& opts, size_t n_tokens) {
+    if (opts.memory_limit == 0) return ~mp_bitcnt_t(0);
+    if (opts.memory_limit <= outputBytes(opts)) return 0;
+    size_t per_value = (opts.memory_limit - outputBytes(opts)) / valuesHeld(n_tokens);
+    if (per_value <= valueBytes(0)) return 0;
+    return static_cast<mp_bitcnt_t>((per_value - valueBytes(0)) / sizeof(mp_limb_t)) * GMP_NUMB_BITS;
+}
+
+EvalResult Engine::evaluate(const std::vector<Token>& tokens, const EvalOptions& opts) {
+    TRACE_SCOPE("evaluate");
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    if (opts.time_limit_ms != 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opts.time_limit_ms);
+
+    if (opts.exact) {
+        EvalResult r;
+        if (evaluateExact(tokens, opts, deadline, r)) return r;
+    }
+
+    long lost_bits = 0;
+    if (opts.precision != 0) {
+        EvalResult r = evaluateAt(tokens, opts, opts.precision, deadline, lost_bits);
+        r.attempts = 1;
+        return r;
+    }
+
+    const mp_bitcnt_t needed = bitsForDigits(opts.digits);
+    mp_bitcnt_t prec = needed + kGuardBits;
+    // retries stop where the memory budget ends; the first attempt is
+    // refused by evaluateAt if even that does not fit
+    const mp_bitcnt_t ceiling = std::max(prec,
+        std::min(std::max(kMaxAdaptivePrecision, needed + kGuardBits), maxPrecisionFor(opts, tokens.size())));
+    std::string prev;
+    unsigned attempts = 0;
+    bool prev_residue = false;
+
+    for (;;) {
+        EvalResult r = evaluateAt(tokens, opts, prec, deadline, lost_bits);
+        r.attempts = ++attempts;
+
+        // A non-zero result that cancelled all but the guard bits is either a
+        // tiny value or what is left of the operands' rounding (0.1+0.2-0.3).
+        // A tiny value keeps its size once the precision covers it; a residue
+        // follows the precision down, so two in a row mean the result is 0.
+        bool residue = r.ok() && mpf_sgn(r.value.get_mpf_t()) != 0
+            && lost_bits >= 0 && static_cast<mp_bitcnt_t>(lost_bits) + kGuardBits >= prec;
+        if (residue && prev_residue) {
+            r.value = 0;
+            return r;
+        }
+        prev_residue = residue;
+
+        bool done = !r.ok() || prec >= ceiling
+            || lost_bits < 0 || static_cast<mp_bitcnt_t>(lost_bits) + needed + 8 <= prec;   // enough correct bits survived
+        if (!done) {
+            std::string cur = leadingDigits(r.value, opts.digits);
+            done = (attempts > 1 && cur == prev);   // displayed digits are stable
+            prev.swap(cur);
+        }
+        if (done) {
+            // round off the bits that only hold rounding noise, so conversions
+            // see 2 rather than 1.999... for 8^(1/3)
+            round_to_bits(r.value, prec - kGuardBits / 2);
+            return r;
+        }
+
+        TRACE_COUNT("precision retries", 1);
+        mp_bitcnt_t next = std::max(2 * prec, needed + static_cast<mp_bitcnt_t>(lost_bits) + kGuardBits);
+        prec = std::min(next, ceiling);
+    }
+}
+
+// False when the expression has to be evaluated in floating point. The
+// fraction's numerator and denominator share the memory budget with the
+// values of the expression.
+bool Engine::evaluateExact(const std::vector<Token>& tokens, const EvalOptions& opts,
+    std::chrono::steady_clock::time_point deadline, EvalResult& r)
+{
+    const mp_bitcnt_t prec = opts.precision != 0 ? opts.precision : bitsForDigits(opts.digits) + kGuardBits;
+    size_t max_bits = kMaxExactBits;
+    if (opts.memory_limit != 0)
+        max_bits = std::min(max_bits, opts.memory_limit * 8 / (2 * valuesHeld(tokens.size())));
+
+    EvalContext ctx(opts, nullptr, *stack, prec);
+    ctx.deadline = deadline;
+    try {
+        auto prog = compileExactCached(ctx, exacts.get(), tokens);
+        if (!prog || !runExact(ctx, *prog, max_bits, stack->fractions(), r.rational)) return false;
+    }
+    catch (const EvalCancelled&) {
+        r.status = EvalStatus::Cancelled;
+        r.error = "Cancelled";
+        return true;
+    }
+    catch (const EvalOverBudget& e) {
+        r.status = EvalStatus::BudgetExceeded;
+        r.error = e.message;
+        return true;
+    }
+    r.exact = true;
+    r.precision = prec;
+    r.attempts = 1;
+    r.value.set_prec(prec);
+    r.value = r.rational;
+    return true;
+}
+
+EvalStatus Engine::compile(const std::vector<Token>& tokens, const EvalOptions& opts) {
+    mp_bitcnt_t prec = opts.precision != 0 ? opts.precision : bitsForDigits(opts.digits) + kGuardBits;
+    if (prec > maxPrecisionFor(opts, tokens.size())) return EvalStatus::BudgetExceeded;
+
+    EvalContext ctx(opts, cache.get(), *stack, prec);
+    ctx.folds = folds.get();
+    if (opts.time_limit_ms != 0)
+        ctx.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opts.time_limit_ms);
+    try {
+        compileCached(ctx, tokens.data(), tokens.data() + tokens.size());
+    }
+    catch (const std::invalid_argument&) { return EvalStatus::SyntaxError; }
+    catch (const EvalCancelled&) { return EvalStatus::Cancelled; }
+    catch (const EvalOverBudget&) { return EvalStatus::BudgetExceeded; }
+    return EvalStatus::Ok;
+}
+
+EvalResult Engine::evaluateAt(const std::vector<Token>& tokens, const EvalOptions& opts,
+    mp_bitcnt_t prec, std::chrono::steady_clock::time_point deadline, long& lost_bits)
+{
+    EvalResult r;
+    r.precision = prec;
+    if (prec > maxPrecisionFor(opts, tokens.size())) {
+        r.status = EvalStatus::BudgetExceeded;
+        r.error = "Error: memory limit";
+        return r;
+    }
+
+    EvalContext ctx(opts, cache.get(), *stack, prec);
+    ctx.folds = folds.get();
+    ctx.deadline = deadline;
+    r.value.set_prec(prec);
+
+    try {
+        r.value = evaluateTokens(ctx, tokens);
+    }
+    catch (const std::invalid_argument&) {
+        // thrown by the parser, and by mpf_class on malformed literals such as "1..2"
+        r.status = EvalStatus::SyntaxError;
+        r.error = "Error: syntax";
+        r.value = 0;
+        return r;
+    }
+    catch (const EvalCancelled&) {
+        r.status = EvalStatus::Cancelled;
+        r.error = "Cancelled";
+        r.value = 0;
+        return r;
+    }
+    catch (const EvalOverBudget& e) {
+        r.status = EvalStatus::BudgetExceeded;
+        r.error = e.message;
+        r.value = 0;
+        return r;
+    }
+    lost_bits = ctx.lost_bits;
+
+    if (!ctx.error.empty()) {
+        r.status = EvalStatus::DomainError;
+        r.error = ctx.error;
+    }
+    else if (ctx.div0) {
+        r.status = EvalStatus::DivideByZero;
+        r.error = "undefined";
+    }
+    return r;
+}
@@ -0,0 +1,249 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+// Headless evaluation core shared by the Qt GUI and the command-line tools.
+// Nothing in here may depend on Qt.
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+typedef mpf_class BigFloat;
+
+enum AngleUnit {
+    ANG_DEG = 0,
+    ANG_RAD = 1,
+    ANG_GRAD = 2
+};
+
+enum class EvalStatus {
+    Ok,
+    DivideByZero,   // x/0 or x mod 0, shown as "undefined"
+    DomainError,    // e.g. ln(-1); message holds the text shown to the user
+    SyntaxError,    // malformed literal such as "1..2", unbalanced ')', missing operand
+    Cancelled,      // EvalOptions::cancel was raised before the result was ready
+    BudgetExceeded  // over EvalOptions::time_limit_ms or memory_limit; message says which
+};
+
+// ===== Tokens =====
+// One element of an expression. The GUI builds these in its equation buffer
+// and the text front end splits a string into them; either way a number is a
+// single token from input to evaluation.
+
+enum class TokenKind : unsigned char {
+    Number,       // unsigned literal in `text`, e.g. "12.5"
+    Operator,     // `op` is one of + - * / ^, or '%' for mod; the Programmer view's
+                  // AND OR XOR LSH RSH NOT are '&' '|' 'x' '<' '>' '~'
+    LParen,
+    RParen,
+    Comma,
+    Function,     // `func` says which; FUNC_PI and FUNC_E take no argument
+    Ans,
+    Identifier    // unknown name, kept in `text`; a syntax error when evaluated
+};
+
+enum class FuncId : unsigned char {
+    Abs, Pi, E,
+    Sin, Cos, Tan, Asin, Acos, Atan,
+    Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+    Ln, Log10, Sqrt, Sqr, Recip, Exp, Exp10,
+    Fact, Mod, Percent, Xroot
+};
+
+struct Token {
+    TokenKind kind = TokenKind::Identifier;
+    char op = 0;                  // Operator only
+    FuncId func = FuncId::Abs;    // Function only
+    std::string text;             // Number digits or Identifier name
+
+    Token() = default;
+
+    // Classify a token in the GUI's spelling: "(", "+", "mod", "ANS",
+    // "FUNC_SIN", "12.5". Implicit so the GUI can keep pushing literals.
+    Token(const char* spelling);
+    Token(const std::string& spelling);
+
+    static Token number(std::string digits);
+    static Token oper(char op);
+    static Token function(FuncId f);
+
+    bool isNumber() const { return kind == TokenKind::Number; }
+    bool isOperator() const { return kind == TokenKind::Operator; }
+    bool isOperator(char c) const { return kind == TokenKind::Operator && op == c; }
+    bool isFunction(FuncId f) const { return kind == TokenKind::Function && func == f; }
+
+    // Inverse of the spelling constructor ("FUNC_SIN", "mod", "12.5", ...)
+    std::string spelling() const;
+};
+
+// Split text such as "sin(30) + 2ans" into the token stream the GUI builds in
+// its equation buffer; Engine::evaluate(string_view) starts with this
+std::vector<Token> tokenize(std::string_view expr);
+
+struct EvalOptions {
+    AngleUnit angle_unit = ANG_DEG;   // unit for trig inputs / inverse trig outputs
+    BigFloat ans = 0;                 // value substituted for ANS
+
+    // Precision policy. By default the working precision is derived from the
+    // number of significant digits the caller is going to show (plus guard
+    // bits) and raised automatically when cancellation eats into it.
+    unsigned digits = 24;             // significant digits that must be right
+    mp_bitcnt_t precision = 0;        // fixed working precision in bits (0 = adaptive)
+
+    // Raised (from any thread) to abandon the evaluation, which then returns
+    // EvalStatus::Cancelled. Polled between instructions and inside the long
+    // loops (factorial, integer powers); the engine never clears it.
+    const std::atomic<bool>* cancel = nullptr;
+
+    // Exact mode: an expression that only adds, subtracts, multiplies,
+    // divides and takes integer powers of decimal literals (and of ANS when
+    // ans_is_exact), plus mod and factorials of integers, is evaluated as a
+    // fraction, and EvalResult::exact is set.
+    // Anything else, e.g. a transcendental function or a fraction too long to
+    // be worth it, is evaluated in floating point as if this were off.
+    bool exact = false;
+    bool ans_is_exact = false;        // exact_ans holds the exact value of ANS
+    mpq_class exact_ans = 0;
+
+    // Budgets for one call of Engine::evaluate, 0 = unlimited. The time covers
+    // every precision retry and is checked along with `cancel`; work whose
+    // length is known up front (n!) is refused at once when it cannot finish
+    // in time. The memory limit bounds the limb storage of the values held
+    // at once: a fixed precision that does not fit is refused before any
+    // work, and adaptive retries stop at the largest precision that fits.
+    unsigned time_limit_ms = 0;
+    size_t memory_limit = 0;          // bytes
+
+    // Debugging: print the optimizer's node counts to stderr whenever an
+    // expression is compiled (cache hits print nothing)
+    bool dump_optimizer = false;
+};
+
+struct EvalResult {
+    EvalStatus status = EvalStatus::Ok;
+    BigFloat value = 0;
+    std::string error;   // user-facing message when status != Ok
+    mp_bitcnt_t precision = 0;   // working precision (bits) of the final attempt
+    unsigned attempts = 0;       // evaluations run, > 1 when cancellation forced a retry
+    bool exact = false;          // evaluated as a fraction (EvalOptions::exact)
+    mpq_class rational = 0;      // the exact value when `exact`; `value` is it rounded
+
+    bool ok() const { return status == EvalStatus::Ok; }
+};
+
+// Counters of the compiled-expression cache
+struct CacheStats {
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+    unsigned long long evictions = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+class ProgramCache;
+class FoldCache;
+class ExactCache;
+class EvalStack;
+
+class Engine
+{
+public:
+    // cache_capacity = number of compiled expressions kept (0 disables the cache,
+    // and with it the reuse of costly constant subexpressions between calls)
+    explicit Engine(size_t cache_capacity = 256);
+    ~Engine();
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Evaluate an expression written as text, e.g. "FUNC_SIN(30)+2*ANS" or
+    // "sin(30) + 2*ans". Function names are case-insensitive and may be given
+    // either as the GUI token (FUNC_SQRT) or by their short name (sqrt).
+    EvalResult evaluate(std::string_view expr, const EvalOptions& opts = EvalOptions());
+
+    // Evaluate the GUI's token stream (equation_buffer with the entry committed)
+    EvalResult evaluate(const std::vector<Token>& tokens, const EvalOptions& opts = EvalOptions());
+
+    // Parse, optimize and lower the tokens into the expression cache without
+    // running them, at the precision the first attempt of evaluate() uses.
+    // Returns SyntaxError when they do not parse.
+    EvalStatus compile(const std::vector<Token>& tokens, const EvalOptions& opts = EvalOptions());
+
+    CacheStats cacheStats() const;
+    void clearCache();
+
+private:
+    EvalResult evaluateAt(const std::vector<Token>& tokens, const EvalOptions& opts,
+        mp_bitcnt_t prec, std::chrono::steady_clock::time_point deadline, long& lost_bits);
+    bool evaluateExact(const std::vector<Token>& tokens, const EvalOptions& opts,
+        std::chrono::steady_clock::time_point deadline, EvalResult& r);
+
+    std::unique_ptr<ProgramCache> cache;
+    std::unique_ptr<FoldCache> folds;
+    std::unique_ptr<ExactCache> exacts;
+    std::unique_ptr<EvalStack> stack;
+};
+
+// Formatting helpers shared by the front ends
+
+// One decimal conversion of a result, for showing it in more than one form.
+// The digits are produced once, for the longest form asked for, and every
+// form is cut from them. GMP converts long mantissas by divide and conquer,
+// so a result with a million digits costs about as much as a multiplication.
+class DecimalForm
+{
+public:
+    static constexpr size_t kDisplayDigits = 80;   // what display() reads
+
+    // Converts max(digits, kDisplayDigits) significant digits of x
+    explicit DecimalForm(const mpf_class& x, size_t digits = kDisplayDigits);
+
+    // Short form for the display: fixed or e-notation, at most 24 characters
+    std::string display(int max_decimals = 21,
+        int sci_sig = 21,
+        int sci_pos_thresh = 20,   // |x| >= 1e20
+        int sci_neg_thresh = -5) const;  // |x| <= 1e-5
+
+    // Decimal string with up to `digits` significant digits, at most
+    // digits() of them: written out without an exponent unless that would
+    // need more padding zeros than there are digits, then in e-notation
+    std::string plain(size_t digits) const;
+
+    size_t digits() const { return ndigits; }
+
+private:
+    // The digits rounded half-up to `keep`, trailing zeros dropped, and their exponent
+    std::string rounded(size_t keep, long& exp) const;
+
+    mpf_class value;    // for the rare rounding the digits cannot decide
+    std::string mant;   // significant digits without sign or trailing zeros; empty for 0
+    long exp10 = 0;     // x = 0.mant × 10^exp10
+    bool neg = false;
+    size_t ndigits;
+};
+
+// DecimalForm(x).display(...)
+std::string format_for_display(const mpf_class& x,
+    int max_decimals = 21,
+    int sci_sig = 21,
+    int sci_pos_thresh = 20,   // |x| >= 1e20
+    int sci_neg_thresh = -5);  // |x| <= 1e-5
+
+// DecimalForm(x, digits).plain(digits)
+std::string mpf_to_string(const mpf_class& x, size_t digits = 34);
+
+// A fraction written exactly: "42", "0.375" when the decimal terminates,
+// otherwise "1/3"
+std::string format_exact(const mpq_class& q);
+
+// "12.5", "-3", ".5e-7" as an exact fraction; false on anything else
+bool parse_exact(const std::string& text, mpq_class& q);
+
+#endif // ENGINE_H
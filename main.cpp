@@ -1,10 +1,20 @@
 #include "mainwindow.h"
+#include "batch.h"
+#include "convert.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
-    // ~8192 bits (~2460 decimal digits); pick a value that fits your perf profile
-    mpf_set_default_prec(8192);
+    // Default for the GUI's own values (entry, memory, ANS). The engine picks
+    // its working precision per evaluation (see EvalOptions::digits).
+    mpf_set_default_prec(256);
+
+    // numeric-engine --batch in.txt --out out.txt: evaluate a file without the GUI
+    if (is_batch_invocation(argc, argv))
+        return batch_main(argc, argv);
+    // numeric-engine --convert in.csv --column 2 --from ft --to m: one column of a CSV file
+    if (is_convert_invocation(argc, argv))
+        return convert_main(argc, argv);
 
     QApplication a(argc, argv);
     MainWindow w;
@@ -1,17 +1,34 @@
 ﻿#include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <QApplication>
 #include <QDebug> // for outputting debug messages
+#include <QDialog>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QShortcut>
+#include <QStatusBar>
+#include <QTimer>
+#include <QtConcurrent>
 
 #include "converter.h" // Include header for Converter form
 #include "settings.h" // Include header for Settings form
 #include "help.h" // Include header for Help form
 #include "about.h" // Include header for About form
+#include "engine.h" // Headless evaluator (numeric_engine_core)
+#include "wordint.h" // Fixed-width integers for the Programmer view
+#include "trace.h" // Stage timers for the diagnostics panel
 
 #include <gmp.h> // to handle the Arithmetic
 #include <gmpxx.h>   // <-- add (C++ API; keep <gmp.h> or remove if unused)
+#include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <cstdio>     // for std::snprintf
 #include <sstream>    // for std::ostringstream
 #include <iomanip>    // for std::fixed and std::setprecision
 #include <random>
@@ -20,13 +37,10 @@
 #include <vector>
 
 // Initialize important variables globally
-typedef mpf_class BigFloat;
-
-std::vector<std::string> equation_buffer;
+std::vector<Token> equation_buffer;
 std::vector<std::string> equation_display;
-std::vector<std::string> numeric_input_buffer = { "0" };
+std::string numeric_input_buffer = "0";   // the entry being typed, digits and '.'
 std::string equation = "";
-std::string last_eval_error;
 bool dp_used = false;
 bool number_is_negative = false;
 bool new_number = true;
@@ -36,521 +50,157 @@ bool just_evaluated = false;
 bool just_evaluated_full = false;   // true only when '=' was pressed
 
 BigFloat last_answer = 0;
+mpq_class last_answer_exact = 0;   // ANS as a fraction, when the engine found it exactly
+bool last_answer_is_exact = false;
 BigFloat memory = 0;
 
+// Programmer view: whole numbers of prog_width bits, typed in prog_radix
+bool programmer_mode = false;
+unsigned prog_width = 64;
+int prog_radix = 16;
+WordInt prog_answer(64);   // ANS of the Programmer view
+WordInt bases_shown(64);   // what the base panel shows, when bases_valid
+bool bases_valid = false;
+
 // Define important functions
 std::string concat_numeric_input_buffer_content() {
-    std::string output = "";
-    output += number_is_negative ? "-" : "";
-    for (std::string c : numeric_input_buffer) {
-        output += c;
-    }
-    return output;
+    return number_is_negative ? "-" + numeric_input_buffer : numeric_input_buffer;
 }
 
 std::string concat_equation_buffer_content() {
     std::string output = "";
-    for (std::string c : equation_buffer) {
-        output += c;
+    for (const Token& t : equation_buffer) {
+        output += t.spelling();
     }
     return output;
 }
 
-// DEBUG: output numeric input buffer and equation buffer
-void input_dbg() {
-    qDebug() << "Numeric Input Buffer: ";
-    qDebug() << QString::fromStdString(concat_numeric_input_buffer_content());  // <-- convert
-    qDebug() << "Equation Buffer: ";
-    qDebug() << QString::fromStdString(concat_equation_buffer_content());       // <-- convert
-    qDebug() << "\n";
-}
-
-// ===== Postfix (RPN) evaluator with GMP =====
-static bool g_eval_div0 = false;
-
-// Tokenize into numbers, operators, parentheses, with unary minus as "u-"
-static std::vector<std::string> tokenizeInfix(const std::string& s) {
-    std::vector<std::string> out;
-    auto isop = [](char c) { return c == '+' || c == '-' || c == '*' || c == '/' || c == '^'; };
-    const size_t n = s.size();
-
-    for (size_t i = 0; i < n; ++i) {
-        char c = s[i];
-        if (std::isspace(static_cast<unsigned char>(c))) continue;
-
-        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
-            std::string num;
-            while (i < n && (std::isdigit(static_cast<unsigned char>(s[i])) || s[i] == '.')) num += s[i++];
-            --i; out.push_back(num);
-        }
-        else if (std::isalpha(static_cast<unsigned char>(c))) {
-            // read identifier
-            std::string id;
-            while (i < n && std::isalpha(static_cast<unsigned char>(s[i]))) {
-                id.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(s[i]))));
-                ++i;
-            }
-            --i;
-            if (id == "mod") out.push_back("mod");
-            // (ignore other identifiers here; function calls get expanded earlier)
-        }
-        else if (c == '(' || c == ')') {
-            out.emplace_back(1, c);
-        }
-        else if (isop(c)) {
-            // unary minus detection (allow after any operator or '(')
-            bool unary = false;
-            if (c == '-') {
-                if (out.empty()) unary = true;
-                else {
-                    const std::string& prev = out.back();
-                    if (prev == "(" || prev == "+" || prev == "-" || prev == "*" || prev == "/" || prev == "^" || prev == "mod")
-                        unary = true;
-                }
-            }
-            if (unary) out.push_back("u-");
-            else out.emplace_back(1, c);
-        }
-    }
-    return out;
-}
-
-static int prec(const std::string& op) {
-    if (op == "u-") return 4;
-    if (op == "^")  return 3;
-    if (op == "*" || op == "/" || op == "mod") return 2;   // ← added
-    if (op == "+" || op == "-") return 1;
-    return 0;
-}
-
-static bool isOp(const std::string& t) {
-    return t == "+" || t == "-" || t == "*" || t == "/" || t == "^" || t == "u-" || t == "mod"; // ← added
-}
-
-static std::vector<std::string> infixToPostfix(const std::vector<std::string>& toks) {
-    std::vector<std::string> out; out.reserve(toks.size());
-    std::vector<std::string> st;
-    for (const auto& t : toks) {
-        if (isOp(t)) {
-            while (!st.empty() && isOp(st.back()) && ((prec(st.back()) > prec(t)) || (prec(st.back()) == prec(t) && t != "u-"))) {
-                out.push_back(st.back()); st.pop_back();
-            }
-            st.push_back(t);
-        }
-        else if (t == "(") {
-            st.push_back(t);
-        }
-        else if (t == ")") {
-            while (!st.empty() && st.back() != "(") { out.push_back(st.back()); st.pop_back(); }
-            if (!st.empty() && st.back() == "(") st.pop_back();
-        }
-        else {
-            out.push_back(t);
-        }
-    }
-    while (!st.empty()) { if (st.back() != "(") out.push_back(st.back()); st.pop_back(); }
-    return out;
-}
-
-static BigFloat toBig(const std::string& s) { BigFloat v(s); return v; }
-
-static BigFloat pow_int(BigFloat base, long long exp) {
-    if (exp == 0) return BigFloat(1);
-    bool neg = (exp < 0);
-    unsigned long long n = neg ? (unsigned long long)(-exp) : (unsigned long long)exp;
-    BigFloat res = 1;
-    while (n) {
-        if (n & 1ULL) res *= base;
-        if (n > 1)    base *= base;
-        n >>= 1ULL;
-    }
-    return neg ? (BigFloat(1) / res) : res;
-}
-
-static BigFloat evalPostfix(const std::vector<std::string>& rpn) {
-    std::vector<BigFloat> st;
-    for (const auto& t : rpn) {
-        if (!isOp(t)) { st.push_back(toBig(t)); continue; }
-        if (t == "u-") {
-            if (st.empty()) return BigFloat(0);
-            BigFloat a = st.back(); st.pop_back(); st.push_back(-a); continue;
-        }
-        if (st.size() < 2) return BigFloat(0);
-        BigFloat b = st.back(); st.pop_back();
-        BigFloat a = st.back(); st.pop_back();
-        if (t == "+") st.push_back(a + b);
-        else if (t == "-") st.push_back(a - b);
-        else if (t == "*") st.push_back(a * b);
-        else if (t == "/") {
-            if (b == 0) { g_eval_div0 = true; st.push_back(BigFloat(0)); } // do not attempt inf/NaN
-            else st.push_back(a / b);
-        }
-        else if (t == "^") {
-            // Use full-precision integer exponent when possible
-            double bd = b.get_d();
-            long long bi = static_cast<long long>(bd);
-            if (std::fabs(bd - static_cast<double>(bi)) < 1e-12) {
-                st.push_back(pow_int(a, bi));
-            }
-            else {
-                // fallback for non-integer exponents
-                st.push_back(BigFloat(::pow(a.get_d(), b.get_d())));
-            }
-        }
-        else if (t == "mod") {
-            if (b == 0) {              // x mod 0 → “undefined” like division by zero
-                g_eval_div0 = true;
-                st.push_back(BigFloat(0));
-            }
-            else {
-                // C/C++ fmod semantics: sign follows the dividend (a)
-                double r = std::fmod(a.get_d(), b.get_d());
-                st.push_back(BigFloat(r));
-            }
-        }
-    }
-    return st.empty() ? BigFloat(0) : st.back();
-}
-
-static BigFloat evaluateFromInfix(const std::string& expr) {
-    g_eval_div0 = false;
-    auto toks = tokenizeInfix(expr);
-    auto rpn = infixToPostfix(toks);
-    return evalPostfix(rpn);
-}
-
-static std::string format_fixed(const mpf_class& x, int max_decimals) {
-    // get a long mantissa then round/cut to max_decimals in fixed form
-    mp_exp_t exp = 0;
-    std::string mant = x.get_str(exp, 10, 80); // 80+ digits headroom
-    bool neg = (!mant.empty() && mant[0] == '-');
-    if (neg) mant.erase(mant.begin());
-    if (mant.empty()) return "0";
-
-    std::string s;
-    if (exp <= 0) {
-        s += neg ? "-0." : "0.";
-        s.append(static_cast<size_t>(-exp), '0');
-        s += mant;
-    }
-    else if (static_cast<size_t>(exp) >= mant.size()) {
-        s += neg ? "-" : "";
-        s += mant;
-        s.append(static_cast<size_t>(exp) - mant.size(), '0');
-    }
-    else {
-        s += neg ? "-" : "";
-        s.append(mant, 0, static_cast<size_t>(exp));
-        s.push_back('.');
-        s.append(mant, static_cast<size_t>(exp), std::string::npos);
-    }
-
-    // round/cut to max_decimals
-    auto dot = s.find('.');
-    if (dot != std::string::npos) {
-        size_t want = dot + 1 + static_cast<size_t>(max_decimals);
-        if (s.size() > want) {
-            // simple cut (optional: implement half-up rounding)
-            s.resize(want);
-        }
-        // trim trailing zeros
-        while (!s.empty() && s.back() == '0') s.pop_back();
-        if (!s.empty() && s.back() == '.') s.pop_back();
+// Append the current entry to `toks` as one number token, as "( - n )" when negative
+static void commit_entry(std::vector<Token>& toks) {
+    std::string x = concat_numeric_input_buffer_content();
+    bool neg = !x.empty() && x[0] == '-';
+    if (neg) {
+        x.erase(x.begin());
+        toks.push_back("(");
+        toks.push_back("-");
     }
-    return s.empty() ? "0" : s;
+    toks.push_back(Token::number(std::move(x)));
+    if (neg) toks.push_back(")");
 }
 
-// Round a digit-only mantissa to `keep` significant digits (half-up), with carry propagation.
-static void round_digit_mantissa(std::string& d, int keep) {
-    if ((int)d.size() <= keep) return;
-    int carry = (d[keep] >= '5') ? 1 : 0;
-    d.resize(keep);
-    for (int i = keep - 1; i >= 0 && carry; --i) {
-        int v = (d[i] - '0') + carry;
-        d[i] = char('0' + (v % 10));
-        carry = v / 10;
-    }
-    if (carry) d.insert(d.begin(), '1'); // e.g., 9..9 -> 10..0, bumps exponent
+// The Programmer view's entry as a word; 0 when it does not parse
+static WordInt current_entry_to_word() {
+    WordInt v(prog_width);
+    WordInt::parse(prog_width, numeric_input_buffer, prog_radix, v);
+    return number_is_negative ? word_neg(v) : v;
 }
 
-static std::string format_scientific_e(const mpf_class& x, int sig_digits) {
-    if (x == 0) return "0";
-
-    mp_exp_t exp10 = 0;
-    std::string mant = x.get_str(exp10, 10, sig_digits + 2); // a little headroom
-    bool neg = (!mant.empty() && mant[0] == '-');
-    if (neg) mant.erase(mant.begin());
-
-    // mant like "12345..." with exp10 meaning 1.2345... × 10^(exp10-1)
-    std::string m = mant;
-    if (m.size() > 1) {
-        m.insert(m.begin() + 1, '.');  // 1.xxx
-    }
-
-    // trim decimals to sig_digits total significant figures
-    if (auto p = m.find('.'); p != std::string::npos) {
-        // keep: 1 digit, '.', and (sig_digits - 1) decimal digits
-        size_t keep = 1 + 1 + (sig_digits - 1);
-        if (m.size() > keep) m.resize(keep);
-
-        // strip trailing zeros and possible trailing '.'
-        while (!m.empty() && m.back() == '0') m.pop_back();
-        if (!m.empty() && m.back() == '.') m.pop_back();
-    }
-
-    long e = static_cast<long>(exp10) - 1;
-
-    std::string out;
-    if (neg) out.push_back('-');
-    out += m;
-    out += 'e';
-    if (e >= 0) out.push_back('+');
-    out += std::to_string(e);
-
-    return out;
+// A word as the Programmer view writes it: the bit pattern, signed in DEC
+static std::string word_display(const WordInt& v) {
+    return v.toString(prog_radix, prog_radix == 10);
 }
 
-static std::string format_scientific(const mpf_class& x, int sig_digits) {
-    if (x == 0) return "0";
-    mp_exp_t exp10 = 0;
-    std::string mant = x.get_str(exp10, 10, sig_digits + 2); // a little headroom
-    bool neg = (!mant.empty() && mant[0] == '-');
-    if (neg) mant.erase(mant.begin());
-
-    // mant like "12345..." with exp10 meaning 1.2345... × 10^(exp10-1)
-    std::string m = mant;
-    if (m.size() > 1) m.insert(m.begin() + 1, '.');
-
-    // trim decimals
-    if (auto p = m.find('.'); p != std::string::npos) {
-        // keep (sig_digits) significant digits total
-        size_t keep = 1 + 1 + (sig_digits - 1); // "d" "." + (sig-1)
-        if (m.size() > keep) m.resize(keep);
-        while (!m.empty() && m.back() == '0') m.pop_back();
-        if (!m.empty() && m.back() == '.') m.pop_back();
-    }
-
-    long e = static_cast<long>(exp10) - 1;
-    return std::string(neg ? "-" : "") + m + " × 10^" + std::to_string(e);
+// Put a word in the entry, with the sign in number_is_negative
+static void load_entry_from_word(const WordInt& v) {
+    std::string s = word_display(v);
+    number_is_negative = !s.empty() && s[0] == '-';
+    if (number_is_negative) s.erase(s.begin());
+    numeric_input_buffer = std::move(s);
+    dp_used = false;
 }
 
-static std::string shrink_for_display(const std::string& s, std::size_t max_chars = 24)
-{
-    if (s.size() <= max_chars) return s;
-
-    // Look for scientific 'e' notation
-    std::size_t epos = s.find('e');
-    if (epos == std::string::npos) {
-        // Not scientific: just hard truncate from the right
-        return s.substr(0, max_chars);
-    }
-
-    // Split into mantissa (with sign) and exponent
-    std::string mant = s.substr(0, epos);   // e.g. "-1.23456789"
-    std::string exp = s.substr(epos);      // e.g. "e+12345"
-
-    // While the whole thing is too long, try to drop fractional digits
-    while (mant.size() + exp.size() > max_chars) {
-        // Find decimal point in mantissa
-        std::size_t dot = mant.find('.');
-        if (dot == std::string::npos) {
-            // No decimal point → nothing fractional to drop
-            break;
-        }
-        if (mant.size() <= dot + 1) {
-            // Nothing after "." to drop
-            break;
-        }
-
-        // Drop one character from the end (a fractional digit)
-        mant.pop_back();
-
-        // Clean up trailing zeros and possibly the '.' itself
-        while (!mant.empty() && mant.back() == '0') mant.pop_back();
-        if (!mant.empty() && mant.back() == '.') mant.pop_back();
+// Digits in groups of `size` from the right, as in "1111 0000"
+static std::string group_digits(const std::string& digits, size_t size) {
+    size_t sign = (!digits.empty() && digits[0] == '-') ? 1 : 0;
+    size_t n = digits.size() - sign;
+    std::string out = digits.substr(0, sign);
+    out.reserve(digits.size() + n / size);
+    for (size_t i = 0; i < n; ++i) {
+        if (i != 0 && (n - i) % size == 0) out.push_back(' ');
+        out.push_back(digits[sign + i]);
     }
-
-    std::string out = mant + exp;
-
-    // As a last resort (huge exponents), just hard truncate
-    if (out.size() > max_chars)
-        out.resize(max_chars);
-
     return out;
 }
 
-static std::string format_for_display(const mpf_class& x,
-    int max_decimals = 21,
-    int sci_sig = 21,
-    int sci_pos_thresh = 20,   // |x| >= 1e20
-    int sci_neg_thresh = -5)   // |x| <= 1e-5
-{
-    if (x == 0) return "0";
-    mp_exp_t e = 0;
-    (void)x.get_str(e, 10, 2);
-    long exp10 = static_cast<long>(e) - 1;
-
-    std::string s;
-    if (exp10 >= sci_pos_thresh || exp10 <= sci_neg_thresh) {
-        // e-notation
-        s = format_scientific_e(x, sci_sig);
-    }
-    else {
-        // fixed notation
-        s = format_fixed(x, max_decimals);
-    }
-
-    // Enforce max display width (24 chars)
-    return shrink_for_display(s, 24);
+static WordOptions word_options() {
+    WordOptions opts;
+    opts.width = prog_width;
+    opts.radix = prog_radix;
+    opts.ans = prog_answer;
+    return opts;
 }
 
-// GMP string formatter (no iostream precision quirks)
-static std::string mpf_to_string(const mpf_class& x, size_t digits = 34) {
-    mp_exp_t exp = 0;                          // digits before decimal
-    std::string mant = x.get_str(exp, 10, digits);
-
-    bool neg = (!mant.empty() && mant[0] == '-');
-    if (neg) mant.erase(mant.begin());
-    if (mant.empty()) return "0";
-
-    std::string s;
-    if (exp <= 0) {
-        if (neg) s.push_back('-');
-        s += "0.";
-        s.append(static_cast<size_t>(-exp), '0');
-        s += mant;
-    }
-    else if (static_cast<size_t>(exp) >= mant.size()) {
-        if (neg) s.push_back('-');
-        s += mant;
-        s.append(static_cast<size_t>(exp) - mant.size(), '0');
-    }
-    else {
-        if (neg) s.push_back('-');
-        s.append(mant, 0, static_cast<size_t>(exp));
-        s.push_back('.');
-        s.append(mant, static_cast<size_t>(exp), std::string::npos);
-    }
-    if (auto p = s.find('.'); p != std::string::npos) {
-        while (!s.empty() && s.back() == '0') s.pop_back();
-        if (!s.empty() && s.back() == '.') s.pop_back();
-    }
-    return s.empty() ? "0" : s;
-}
-
-static std::string stripTrailingOperator(const std::string& s) {
-    if (s.empty()) return s;
-    size_t i = s.size();
-    while (i > 0 && std::isspace(static_cast<unsigned char>(s[i - 1]))) --i;
-    if (i == 0) return "";
-    char c = s[i - 1];
-    if (c == '+' || c == '-' || c == '*' || c == '/') return s.substr(0, i - 1);
-    return s;
-}
-// ===== end RPN evaluator =====
-
-// --- Display-only function detection ---
-static bool isDisplayFunc(const std::string& t) {
-    return
-        t == "FUNC_ABS" ||
-        t == "FUNC_PI" ||
-        t == "FUNC_E" ||
-        t == "FUNC_SIN" ||
-        t == "FUNC_COS" ||
-        t == "FUNC_TAN" ||
-        t == "FUNC_ASIN" ||
-        t == "FUNC_ACOS" ||
-        t == "FUNC_ATAN" ||
-        t == "FUNC_SINH" ||
-        t == "FUNC_COSH" ||
-        t == "FUNC_TANH" ||
-        t == "FUNC_ASINH" ||
-        t == "FUNC_ACOSH" ||
-        t == "FUNC_ATANH" ||
-        t == "FUNC_LN" ||
-        t == "FUNC_LOG10" ||
-        t == "FUNC_SQRT" ||
-        t == "FUNC_SQR" ||
-        t == "FUNC_RECIP" ||
-        t == "FUNC_EXP" ||
-        t == "FUNC_EXP10" ||
-        t == "FUNC_FACT" ||
-        t == "FUNC_MOD" ||
-        t == "FUNC_PERCENT" ||
-        t == "FUNC_XROOT";
+// DEBUG: output numeric input buffer and equation buffer
+void input_dbg() {
+    qDebug() << "Numeric Input Buffer: ";
+    qDebug() << QString::fromStdString(concat_numeric_input_buffer_content());  // <-- convert
+    qDebug() << "Equation Buffer: ";
+    qDebug() << QString::fromStdString(concat_equation_buffer_content());       // <-- convert
+    qDebug() << "\n";
 }
 
 // ===== Pretty-printing the equation (display only) =====
 
-// Merge consecutive digit/decimal tokens into a single number token.
-static std::vector<std::string> coalesceNumbers(const std::vector<std::string>& raw) {
-    std::vector<std::string> out;
-    std::string acc;
-    auto flush_acc = [&]() { if (!acc.empty()) { out.push_back(acc); acc.clear(); } };
-
-    for (const auto& t : raw) {
-        bool isDigit = (t.size() == 1) && (std::isdigit(static_cast<unsigned char>(t[0])) || t == ".");
-        if (isDigit) {
-            acc += t;
-        }
-        else {
-            flush_acc();
-            out.push_back(t);
-        }
-    }
-    flush_acc();
-    return out;
-}
-
-static inline bool isBinaryOpTok(const std::string& t) {
-    return t == "+" || t == "-" || t == "*" || t == "/";
+static inline bool isBinaryOpTok(const Token& t) {
+    return t.isOperator('+') || t.isOperator('-') || t.isOperator('*') || t.isOperator('/');
 }
 
-static bool isUnaryMinusAt(const std::vector<std::string>& toks, size_t i) {
-    if (toks[i] != "-") return false;
+static bool isUnaryMinusAt(const std::vector<Token>& toks, size_t i) {
+    if (!toks[i].isOperator('-')) return false;
     if (i == 0) return true;
-    const std::string& prev = toks[i - 1];
+    const Token& prev = toks[i - 1];
     // If previous is an opening paren or an operator, this '-' is unary
-    return (prev == "(" || isBinaryOpTok(prev));
-}
-
-// --- add these helpers just ABOVE pretty_equation_from_tokens() ---
-
-static bool isNumberToken(const std::string& s) {
-    if (s.empty()) return false;
-    size_t i = 0;
-    if (s[0] == '-') {
-        if (s.size() == 1) return false;
-        i = 1;
-    }
-    bool dp = false;
-    for (; i < s.size(); ++i) {
-        unsigned char c = static_cast<unsigned char>(s[i]);
-        if (std::isdigit(c)) continue;
-        if (s[i] == '.' && !dp) { dp = true; continue; }
-        return false;
-    }
-    return true;
+    return (prev.kind == TokenKind::LParen || isBinaryOpTok(prev));
 }
 
-static bool isValueLikeToken(const std::string& t) {
-    if (t == ")" || t == "ANS" || t == "FUNC_PI" || t == "FUNC_E")
-        return true;
-    // Treat a plain numeric token as a value too
-    return isNumberToken(t);
+static bool isValueLikeToken(const Token& t) {
+    return t.kind == TokenKind::RParen || t.kind == TokenKind::Ans || t.kind == TokenKind::Number
+        || t.isFunction(FuncId::Pi) || t.isFunction(FuncId::E);
 }
 
 // Detect the exact token sequence: "(" "-" <number> ")"
-static bool isNegativeLiteral(const std::vector<std::string>& toks, size_t i) {
+static bool isNegativeLiteral(const std::vector<Token>& toks, size_t i) {
     return (i + 3 < toks.size()
-        && toks[i] == "("
-        && toks[i + 1] == "-"
-        && isNumberToken(toks[i + 2])
-        && toks[i + 3] == ")");
-}
-
-static QString pretty_equation_from_tokens(const std::vector<std::string>& raw) {
-    const auto toks = coalesceNumbers(raw);
+        && toks[i].kind == TokenKind::LParen
+        && toks[i + 1].isOperator('-')
+        && toks[i + 2].isNumber()
+        && toks[i + 3].kind == TokenKind::RParen);
+}
+
+// --- display-only funcs ---
+static QString function_display_name(FuncId f) {
+    switch (f) {
+    case FuncId::Abs:     return "abs";
+    case FuncId::Pi:      return "π";
+    case FuncId::E:       return "e";
+    case FuncId::Sin:     return "sin";
+    case FuncId::Cos:     return "cos";
+    case FuncId::Tan:     return "tan";
+    case FuncId::Asin:    return "sin⁻¹";
+    case FuncId::Acos:    return "cos⁻¹";
+    case FuncId::Atan:    return "tan⁻¹";
+    case FuncId::Sinh:    return "sinh";
+    case FuncId::Cosh:    return "cosh";
+    case FuncId::Tanh:    return "tanh";
+    case FuncId::Asinh:   return "sinh⁻¹";
+    case FuncId::Acosh:   return "cosh⁻¹";
+    case FuncId::Atanh:   return "tanh⁻¹";
+    case FuncId::Ln:      return "ln";
+    case FuncId::Log10:   return "log";
+    case FuncId::Sqrt:    return QStringLiteral("√");
+    case FuncId::Sqr:     return "sqr";
+    case FuncId::Recip:   return "1/";
+    case FuncId::Exp:     return "exp";
+    case FuncId::Exp10:   return "10^";
+    case FuncId::Fact:    return "fact";
+    case FuncId::Mod:     return "mod";
+    case FuncId::Percent: return "% of";
+    case FuncId::Xroot:   return QStringLiteral("√x");
+    }
+    return QString();
+}
+
+static QString pretty_equation_from_tokens(const std::vector<Token>& toks) {
     QString out;
 
     auto lastChar = [&]() -> QChar {
@@ -559,13 +209,13 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
         };
 
     for (size_t i = 0; i < toks.size(); ++i) {
-        const std::string& t = toks[i];
+        const Token& t = toks[i];
 
         // collapse "( - n )" but wrap if it's the base of a power: (-n)^m
         if (isNegativeLiteral(toks, i)) {
             // tokens are: i:"(", i+1:"-", i+2:<num>, i+3:")"
-            bool powAfter = (i + 4 < toks.size() && toks[i + 4] == "^");
-            QString neg = "-" + QString::fromStdString(toks[i + 2]);
+            bool powAfter = (i + 4 < toks.size() && toks[i + 4].isOperator('^'));
+            QString neg = "-" + QString::fromStdString(toks[i + 2].text);
             if (powAfter) {
                 out += "(" + neg + ")";    // show (-n) when immediately followed by ^
             }
@@ -576,71 +226,16 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
             continue;
         }
 
-        // If this token is a number (including negative like "-3"), and the NEXT token is '^',
-        // we should wrap the base in parentheses to show (-x)^y
-        /*if (isNumberToken(t) && (i + 1 < toks.size()) && toks[i + 1] == "^") {
-            // wrap negative or positive numbers only if negative or if user prefers clarity:
-            if (!t.empty() && t[0] == '-') {
-                out += "(" + QString::fromStdString(t) + ")";
-            }
-            else {
-                out += QString::fromStdString(t);
-            }
-            continue;
-        }*/
-        // Wrap negative numbers in parentheses when used as base for power (^)
-        if ((i + 1 < toks.size()) && toks[i + 1] == "^") {
-            // Case 1: plain negative number token "-3"
-            if (isNumberToken(t) && !t.empty() && t[0] == '-') {
-                out += "(" + QString::fromStdString(t) + ")";
-                continue;
-            }
+        if (t.kind == TokenKind::Ans) { out += "Ans"; continue; }
 
-            // Case 2: already parenthesized form "( - 3 )"
-            if (isNegativeLiteral(toks, i)) {
-                QString neg = "-" + QString::fromStdString(toks[i + 2]);
-                out += "(" + neg + ")";
-                i += 3; // skip "( - n )"
-                continue;
-            }
-        }
-
-        // --- display-only funcs ---
-        if (t == "FUNC_ABS") { out += "abs";   continue; }
-        if (t == "ANS") { out += "Ans"; continue; }
-        if (t == "FUNC_PI") { out += "π";     continue; }
-        if (t == "FUNC_E") { out += "e";     continue; }
-        if (t == "FUNC_SIN") { out += "sin";   continue; }
-        if (t == "FUNC_COS") { out += "cos";   continue; }
-        if (t == "FUNC_TAN") { out += "tan";   continue; }
-        if (t == "FUNC_ASIN") { out += "sin⁻¹";  continue; }
-        if (t == "FUNC_ACOS") { out += "cos⁻¹";  continue; }
-        if (t == "FUNC_ATAN") { out += "tan⁻¹";  continue; }
-        if (t == "FUNC_SINH") { out += "sinh";  continue; }
-        if (t == "FUNC_COSH") { out += "cosh";  continue; }
-        if (t == "FUNC_TANH") { out += "tanh";  continue; }
-        if (t == "FUNC_ASINH") { out += "sinh⁻¹"; continue; }
-        if (t == "FUNC_ACOSH") { out += "cosh⁻¹"; continue; }
-        if (t == "FUNC_ATANH") { out += "tanh⁻¹"; continue; }
-        if (t == "FUNC_LN") { out += "ln";    continue; }
-        if (t == "FUNC_LOG10") { out += "log";   continue; }
-        if (t == "FUNC_SQRT") { out += QStringLiteral("√"); continue; }
-        if (t == "FUNC_SQR") { out += "sqr";   continue; }
-        if (t == "FUNC_RECIP") { out += "1/";    continue; }
-        if (t == "FUNC_EXP") { out += "exp";   continue; }
-        if (t == "FUNC_EXP10") { out += "10^";   continue; }
-        if (t == "FUNC_FACT") { out += "fact";     continue; }
-        if (t == "FUNC_MOD") { out += "mod";   continue; }
-        if (t == "FUNC_PERCENT") { out += "% of"; continue; }
-        // if (t == "FUNC_XROOT") { out += QStringLiteral("√x"); continue; } // we'll refine in a sec
-        if (t == "FUNC_XROOT") {
+        if (t.isFunction(FuncId::Xroot)) {
             // FUNC_XROOT(x, y) → √[x](y)
-            if (i + 1 < toks.size() && toks[i + 1] == "(") {
+            if (i + 1 < toks.size() && toks[i + 1].kind == TokenKind::LParen) {
                 int depth = 0;
                 size_t j = i + 1;
                 for (; j < toks.size(); ++j) {
-                    if (toks[j] == "(") ++depth;
-                    else if (toks[j] == ")") {
+                    if (toks[j].kind == TokenKind::LParen) ++depth;
+                    else if (toks[j].kind == TokenKind::RParen) {
                         --depth;
                         if (depth == 0) { ++j; break; }
                     }
@@ -650,21 +245,21 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
                 size_t commaPos = i + 2;
                 int innerDepth = 0;
                 for (; commaPos < j; ++commaPos) {
-                    if (toks[commaPos] == "(") innerDepth++;
-                    else if (toks[commaPos] == ")") innerDepth--;
-                    else if (toks[commaPos] == "," && innerDepth == 0)
+                    if (toks[commaPos].kind == TokenKind::LParen) innerDepth++;
+                    else if (toks[commaPos].kind == TokenKind::RParen) innerDepth--;
+                    else if (toks[commaPos].kind == TokenKind::Comma && innerDepth == 0)
                         break;
                 }
 
                 // Extract root index x
                 QString x;
                 for (size_t k = i + 2; k < commaPos; ++k)
-                    x += QString::fromStdString(toks[k]);
+                    x += QString::fromStdString(toks[k].spelling());
 
                 // Extract radicand y
                 QString y;
                 for (size_t k = commaPos + 1; k < j - 1; ++k)
-                    y += QString::fromStdString(toks[k]);
+                    y += QString::fromStdString(toks[k].spelling());
 
                 // Format √[x](y)
                 out += QStringLiteral("√[") + x.trimmed() + QStringLiteral("](") + y.trimmed() + QStringLiteral(")");
@@ -674,29 +269,9 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
                 continue;
             }
         }
+        if (t.kind == TokenKind::Function) { out += function_display_name(t.func); continue; }
 
-        // ... then your existing code that handles (, ), operators, numbers ...
-        // (keep your × / ÷ logic exactly as you had it)
-        // ...
-
-        // Parentheses: no extra spaces next to them
-        //if (t == "(") {
-        //    // If previous token was a value or ')', you *might* want a space (optional)
-        //    // We keep it tight for a classic calculator look.
-        //    out += "(";
-        //    continue;
-        //}
-
-        // collapse parenthesized negative literals here
-        if (isNegativeLiteral(toks, i)) {
-            QString neg = "-" + QString::fromStdString(toks[i + 2]);
-            // If next token is "^", parentheses will be added in next step
-            out += neg;
-            i += 3;
-            continue;
-        }
-
-        if (t == ")") {
+        if (t.kind == TokenKind::RParen) {
             out += ")";
             continue;
         }
@@ -704,31 +279,35 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
         // Operators
         if (isBinaryOpTok(t)) {
             // Unary minus stays tight (e.g., 1 * -(2) or (-3))
-            if (t == "-" && isUnaryMinusAt(toks, i)) {
+            if (t.isOperator('-') && isUnaryMinusAt(toks, i)) {
                 out += "-";
                 continue;
             }
 
             // Binary operator: add spaces around
             QString sym;
-            if (t == "+") sym = QStringLiteral("+");
-            else if (t == "-") sym = QStringLiteral("−");
-            else if (t == "*")      sym = QStringLiteral("×");
-            else if (t == "/") sym = QStringLiteral("÷");
-            else               sym = QString::fromStdString(t);
+            if (t.op == '+')      sym = QStringLiteral("+");
+            else if (t.op == '-') sym = QStringLiteral("−");
+            else if (t.op == '*') sym = QStringLiteral("×");
+            else                  sym = QStringLiteral("÷");
 
             // no space just after '('
             if (lastChar() != '(' && lastChar() != QChar(' ') && !out.isEmpty())
                 out += " ";
             out += sym;
             // no space just before ')'
-            if (i + 1 < toks.size() && toks[i + 1] != ")")
+            if (i + 1 < toks.size() && toks[i + 1].kind != TokenKind::RParen)
                 out += " ";
             continue;
         }
+        if (t.isOperator('%')) { out += " mod "; continue; }
+        if (t.isOperator() && !t.isOperator('^')) {   // AND, LSH, ... of the Programmer view
+            out += " " + QString::fromStdString(t.spelling()) + " ";
+            continue;
+        }
 
         // Number or any other literal token
-        out += QString::fromStdString(t);
+        out += QString::fromStdString(t.spelling());
     }
 
     return out;
@@ -736,13 +315,18 @@ static QString pretty_equation_from_tokens(const std::vector<std::string>& raw)
 
 // Read the current entry (what the user is typing) as BigFloat
 static BigFloat current_entry_to_big() {
+    if (programmer_mode) return BigFloat(current_entry_to_word().toMpz(true));
     return BigFloat(concat_numeric_input_buffer_content());
 }
 
 // Load a BigFloat into the entry buffer (respecting sign/decimal flags)
 void MainWindow::load_entry_from_big(const mpf_class& x) {
+    if (programmer_mode) {   // the integer part, wrapped to the word length
+        load_entry_from_word(WordInt::fromMpz(prog_width, mpz_class(x)));
+        new_number = false;
+        return;
+    }
     std::string s = mpf_to_string(x, 34);
-    numeric_input_buffer.clear();
 
     number_is_negative = false;
     if (!s.empty() && s[0] == '-') {
@@ -752,389 +336,33 @@ void MainWindow::load_entry_from_big(const mpf_class& x) {
     dp_used = (s.find('.') != std::string::npos);
     new_number = false;
 
-    for (char ch : s) {
-        // s now has only digits and optionally one '.'
-        numeric_input_buffer.push_back(std::string(1, ch));
-    }
-}
-
-static BigFloat big_pi() {
-    // return BigFloat(std::acos(-1.0));
-    return BigFloat("3.14159265358979323846");
+    // s now has only digits and optionally one '.'
+    numeric_input_buffer = std::move(s);
 }
 
 // angle unit helpers
 // --- Global angle mode (mirrors the combo box) ---
 static AngleUnit g_angle_unit = ANG_DEG;
 
-// --- Conversions ---
-static BigFloat rad_to_deg(const BigFloat& r) { return r * 180 / big_pi(); }
-static BigFloat rad_to_grad(const BigFloat& r) { return r * 200 / big_pi(); }
-static BigFloat deg_to_rad(const BigFloat& d) { return d * big_pi() / 180; }
-static BigFloat grad_to_rad(const BigFloat& g) { return g * big_pi() / 200; }
-
-static BigFloat to_radians(const BigFloat& v) {
-    switch (g_angle_unit) {
-    case ANG_RAD:  return v;
-    case ANG_GRAD: return grad_to_rad(v);
-    default:       return deg_to_rad(v);
-    }
-}
-static BigFloat from_radians(const BigFloat& r) {
-    switch (g_angle_unit) {
-    case ANG_RAD:  return r;
-    case ANG_GRAD: return rad_to_grad(r);
-    default:       return rad_to_deg(r);
-    }
-}
-
-// Replace your previous expandDisplayFuncs implementation with this:
-
-static std::string joinTokensToInfix(const std::vector<std::string>& toks, size_t start, size_t end) {
-    // join tokens[start..end-1] with no separators (same flattening your on_button_equals used)
-    std::string s;
-    for (size_t i = start; i < end; ++i) s += toks[i];
-    return s;
-}
-
-static BigFloat evalGroupAsBig(const std::vector<std::string>& toks, size_t start, size_t end) {
-    // Flatten the group to infix and evaluate via your existing evaluator
-    std::string inf = joinTokensToInfix(toks, start, end);
-    return evaluateFromInfix(inf);
-}
-
-// Main expand: turn FUNC_NAME ( ... ) into numeric tokens by evaluating the (...) expression
-static std::vector<std::string> expandDisplayFuncs(const std::vector<std::string>& toks) {
-    std::vector<std::string> out;
-    size_t n = toks.size();
-    for (size_t i = 0; i < n; ++i) {
-        const std::string& t = toks[i];
-
-        // Always expand ANS to its numeric digits for later evaluation.
-        if (t == "ANS") {
-            std::string s = mpf_to_string(last_answer, 34);
-            for (char ch : s) out.push_back(std::string(1, ch));
-            continue;
-        }
-
-        // Always expand FUNC_PI and FUNC_E to their numeric values
-        if (t == "FUNC_PI") {
-            std::string s = mpf_to_string(big_pi(), 34);
-            for (char ch : s) out.push_back(std::string(1, ch));
-            continue;
-        }
-        if (t == "FUNC_E") {
-            BigFloat e(std::exp(1.0));
-            std::string s = mpf_to_string(e, 34);
-            for (char ch : s) out.push_back(std::string(1, ch));
-            continue;
-        }
-
-        // --- special-case: FUNC_SQR ( x ) => replace with (x)*(x) to preserve algebraic behavior
-        if (t == "FUNC_SQR") {
-            // if next is '(' collect group
-            if (i + 1 < n && toks[i + 1] == "(") {
-                // find matching paren
-                int depth = 0;
-                size_t j = i + 1;
-                for (; j < n; ++j) {
-                    if (toks[j] == "(") ++depth;
-                    else if (toks[j] == ")") {
-                        --depth;
-                        if (depth == 0) { ++j; break; }
-                    }
-                }
-                // push group, *, group
-                for (size_t k = i + 1; k < j; ++k) out.push_back(toks[k]);
-                out.push_back("*");
-                for (size_t k = i + 1; k < j; ++k) out.push_back(toks[k]);
-                i = j - 1;
-                continue;
-            }
-            // otherwise ignore
-            continue;
-        }
-
-        // FUNC_RECIP -> 1 / (group)
-        if (t == "FUNC_RECIP") {
-            if (i + 1 < n && toks[i + 1] == "(") {
-                int depth = 0;
-                size_t j = i + 1;
-                for (; j < n; ++j) {
-                    if (toks[j] == "(") ++depth;
-                    else if (toks[j] == ")") {
-                        --depth;
-                        if (depth == 0) { ++j; break; }
-                    }
-                }
-                out.push_back("1");
-                out.push_back("/");
-                for (size_t k = i + 1; k < j; ++k) out.push_back(toks[k]);
-                i = j - 1;
-                continue;
-            }
-            continue;
-        }
-
-        // FUNC_PERCENT -> (group) / 100
-        if (t == "FUNC_PERCENT") {
-            if (i + 1 < n && toks[i + 1] == "(") {
-                int depth = 0;
-                size_t j = i + 1;
-                for (; j < n; ++j) {
-                    if (toks[j] == "(") ++depth;
-                    else if (toks[j] == ")") {
-                        --depth;
-                        if (depth == 0) { ++j; break; }
-                    }
-                }
-                for (size_t k = i + 1; k < j; ++k) out.push_back(toks[k]);
-                out.push_back("/");
-                out.push_back("100");
-                i = j - 1;
-                continue;
-            }
-            continue;
-        }
-
-        // For unary/functions that should be evaluated to a numeric value at "=":
-        if (t.rfind("FUNC_", 0) == 0) {
-            // We will handle functions that take one argument: FUNC_SIN, FUNC_COS, FUNC_TAN, FUNC_LN, FUNC_LOG10, FUNC_SQRT, FUNC_ABS, FUNC_EXP, FUNC_EXP10, FUNC_SINH...
-            // if next token is "(" collect the group and evaluate
-            if (i + 1 < n && toks[i + 1] == "(") {
-                int depth = 0;
-                size_t j = i + 1;
-                for (; j < n; ++j) {
-                    if (toks[j] == "(") ++depth;
-                    else if (toks[j] == ")") {
-                        --depth;
-                        if (depth == 0) { ++j; break; }
-                    }
-                }
-                // ... inside your function handler block, before calling evalGroupAsBig:
-                auto expanded = expandDisplayFuncs(std::vector<std::string>(toks.begin() + i + 2, toks.begin() + j - 1));
-                BigFloat inner = evalGroupAsBig(expanded, 0, expanded.size());
-                // evaluate inner expression to BigFloat
-                // BigFloat inner = evalGroupAsBig(toks, i + 2, j - 1); // skip the outer '(' and ')'
-                BigFloat result = inner;
-
-                // Apply the function
-                // circular trig (inputs depend on unit)
-                if (t == "FUNC_SIN") {
-                    BigFloat vrad = to_radians(inner);
-                    result = BigFloat(::sin(vrad.get_d()));
-                }
-                else if (t == "FUNC_COS") {
-                    BigFloat vrad = to_radians(inner);
-                    result = BigFloat(::cos(vrad.get_d()));
-                }
-                else if (t == "FUNC_TAN") {
-                    BigFloat vrad = to_radians(inner);
-                    result = BigFloat(::tan(vrad.get_d()));
-                }
-                /*else if (t == "FUNC_ASIN") {
-                    result = BigFloat(::asin(inner.get_d()));
-                }
-                else if (t == "FUNC_ACOS") {
-                    result = BigFloat(::acos(inner.get_d()));
-                }*/
-                // inverse circular trig (outputs shown in selected unit)
-                else if (t == "FUNC_ASIN") {
-                    double v = inner.get_d();
-                    if (v < -1.0 || v > 1.0) {
-                        last_eval_error = "Error: asin domain [-1,1]";
-                        out.clear(); out.push_back("0"); continue;
-                    }
-                    BigFloat r = BigFloat(::asin(v));      // radians
-                    result = from_radians(r);
-                }
-                else if (t == "FUNC_ACOS") {
-                    double v = inner.get_d();
-                    if (v < -1.0 || v > 1.0) {
-                        last_eval_error = "Error: acos domain [-1,1]";
-                        out.clear(); out.push_back("0"); continue;
-                    }
-                    BigFloat r = BigFloat(::acos(v));      // radians
-                    result = from_radians(r);
-                }
-                else if (t == "FUNC_ATAN") {
-                    BigFloat r = BigFloat(::atan(inner.get_d()));  // radians
-                    result = from_radians(r);
-                }
-                else if (t == "FUNC_SINH") {
-                    result = BigFloat(::sinh(inner.get_d()));
-                }
-                else if (t == "FUNC_COSH") {
-                    result = BigFloat(::cosh(inner.get_d()));
-                }
-                else if (t == "FUNC_TANH") {
-                    result = BigFloat(::tanh(inner.get_d()));
-                }
-                else if (t == "FUNC_ASINH") {
-                    // principal value: ℝ → ℝ
-                    BigFloat r = BigFloat(std::asinh(inner.get_d()));
-                    result = r;
-                }
-                else if (t == "FUNC_ACOSH") {
-                    // domain: x >= 1
-                    double v = inner.get_d();
-                    if (v < 1.0) {
-                        last_eval_error = "Error: acosh domain [1, +inf)";
-                        out.clear(); out.push_back("0"); continue;
-                    }
-                    BigFloat r = BigFloat(std::acosh(v));
-                    result = r;
-                }
-                else if (t == "FUNC_ATANH") {
-                    // domain: |x| < 1
-                    double v = inner.get_d();
-                    if (!(v > -1.0 && v < 1.0)) {
-                        last_eval_error = "Error: atanh domain (-1, 1)";
-                        out.clear(); out.push_back("0"); continue;
-                    }
-                    BigFloat r = BigFloat(std::atanh(v));
-                    result = r;
-                }
-                else if (t == "FUNC_LN") {
-                    double v = inner.get_d();
-                    if (v <= 0.0) {
-                        last_eval_error = "Error: ln domain (0,∞)";
-                        out.clear();
-                        out.push_back("0");
-                        continue;
-                    }
-                    result = BigFloat(::log(v));
-                }
-                else if (t == "FUNC_LOG10") {
-                    double v = inner.get_d();
-                    if (v <= 0.0) {
-                        last_eval_error = "Error: log domain (0,∞)";
-                        out.clear();
-                        out.push_back("0");
-                        continue;
-                    }
-                    result = BigFloat(::log10(v));
-                }
-                else if (t == "FUNC_SQRT") {
-                    if (inner < 0) {
-                        // leave as is (you may want to handle error earlier); here push "0" to avoid crash
-                        result = BigFloat(0);
-                    }
-                    else {
-                        mpf_t tmp; mpf_init(tmp);
-                        mpf_sqrt(tmp, inner.get_mpf_t());
-                        result = BigFloat(tmp); mpf_clear(tmp);
-                    }
-                }
-                else if (t == "FUNC_ABS") {
-                    if (inner < 0) result = -inner; else result = inner;
-                }
-                else if (t == "FUNC_EXP10") {
-                    result = BigFloat(::pow(10.0, inner.get_d()));
-                }
-                else if (t == "FUNC_EXP") {
-                    // treat as e^x
-                    result = BigFloat(::exp(inner.get_d()));
-                }
-                else if (t == "FUNC_FACT") {
-                    long long nfact = static_cast<long long>(inner.get_d());
-                    if (nfact < 0) {
-                        result = BigFloat(0);
-                    }
-                    else {
-                        BigFloat res = 1;
-                        for (long long k = 2; k <= nfact; ++k) res *= BigFloat(static_cast<double>(k));
-                        result = res;
-                    }
-                }
-                else if (t == "FUNC_XROOT") {
-                    // FUNC_XROOT(x, y) => y^(1/x)
-                    if (i + 1 < n && toks[i + 1] == "(") {
-                        int depth = 0;
-                        size_t j = i + 1;
-                        for (; j < n; ++j) {
-                            if (toks[j] == "(") ++depth;
-                            else if (toks[j] == ")") {
-                                --depth;
-                                if (depth == 0) { ++j; break; }
-                            }
-                        }
-
-                        // Find comma separating x and y
-                        size_t commaPos = i + 2;
-                        int innerDepth = 0;
-                        for (; commaPos < j; ++commaPos) {
-                            if (toks[commaPos] == "(") innerDepth++;
-                            else if (toks[commaPos] == ")") innerDepth--;
-                            else if (toks[commaPos] == "," && innerDepth == 0)
-                                break;
-                        }
-
-                        // Evaluate x and y parts
-                        auto leftPart = std::vector<std::string>(toks.begin() + i + 2, toks.begin() + commaPos);
-                        auto rightPart = std::vector<std::string>(toks.begin() + commaPos + 1, toks.begin() + j - 1);
-
-                        BigFloat x = evalGroupAsBig(leftPart, 0, leftPart.size());
-                        BigFloat y = evalGroupAsBig(rightPart, 0, rightPart.size());
-
-                        if (x == 0) {
-                            // Root 0 is undefined
-                            out.push_back("0");
-                        }
-                        else {
-                            BigFloat result = BigFloat(::pow(y.get_d(), 1.0 / x.get_d()));
-                            std::string s = mpf_to_string(result, 34);
-                            for (char ch : s)
-                                out.push_back(std::string(1, ch));
-                        }
-
-                        i = j - 1;
-                        continue;
-                    }
-                }
-                else {
-                    // unknown FUNC_*, fallback: just append inner tokens (no function application)
-                    for (size_t k = i + 1; k < j; ++k) out.push_back(toks[k]);
-                    i = j - 1;
-                    continue;
-                }
-
-                // push numeric result as tokens (digits and '.' as separate tokens to match other code)
-                std::string s = mpf_to_string(result, 34);
-                for (char ch : s) {
-                    out.push_back(std::string(1, ch));
-                }
-
-                i = j - 1;
-                continue;
-            }
-            else {
-                // unknown no-arg function: skip
-                continue;
-            }
-        }
-
-        // default: copy tokens through
-        out.push_back(t);
-    }
-
-    return out;
-}
-
-static std::vector<std::string> expandDisplayFuncs(const std::vector<std::string>& toks);
 
 void MainWindow::updateDisplay() {
+    TRACE_SCOPE("updateDisplay");
     std::string eq = concat_equation_buffer_content();
     std::string current = concat_numeric_input_buffer_content();
 
     ui->answerInputLabel->setText(QString::fromStdString(current));
     ui->answerInputLabel_2->setText(QString::fromStdString(current));
+    ui->answerInputLabel_3->setText(QString::fromStdString(current));
     // OLD:
     // ui->equationLabel->setText(QString::fromStdString(eq));
 
     // NEW (beautified):
     ui->equationLabel->setText(pretty_equation_from_tokens(equation_buffer));
     ui->equationLabel_2->setText(pretty_equation_from_tokens(equation_buffer));
+    ui->equationLabel_3->setText(pretty_equation_from_tokens(equation_buffer));
+
+    updateBaseDisplay();
+    schedulePreview();
 }
 
 MainWindow::MainWindow(QWidget* parent)
@@ -1326,32 +554,136 @@ MainWindow::MainWindow(QWidget* parent)
     ui->memory_recall->setEnabled(false);
     ui->memory_clear_2->setEnabled(false);
     ui->memory_recall_2->setEnabled(false);
+
+    // The Programmer view has whole numbers only, typed in one base at a time
+    ui->decimal_point_3->setEnabled(false);
+    for (QPushButton* base : { ui->base_hex, ui->base_dec, ui->base_oct, ui->base_bin })
+        base->setCheckable(true);
+    showRadix();
+
+    // Evaluation runs off the GUI thread; a busy bar and a Cancel button show
+    // up in the status bar when it takes longer than a blink
+    evalWatcher = new QFutureWatcher<EvalResult>(this);
+    QObject::connect(evalWatcher, &QFutureWatcher<EvalResult>::finished, this, &MainWindow::evaluationFinished);
+
+    busyIndicator = new QProgressBar(this);
+    busyIndicator->setRange(0, 0);   // no known end: animated busy bar
+    busyIndicator->setTextVisible(false);
+    busyIndicator->setMaximumWidth(120);
+    busyIndicator->setMaximumHeight(14);
+    cancelButton = new QPushButton(tr("Cancel"), this);
+    statusBar()->addPermanentWidget(busyIndicator);
+    statusBar()->addPermanentWidget(cancelButton);
+    busyIndicator->hide();
+    cancelButton->hide();
+    QObject::connect(cancelButton, &QPushButton::clicked, this, &MainWindow::cancelEvaluation);
+    QShortcut* cancelShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    QObject::connect(cancelShortcut, &QShortcut::activated, this, &MainWindow::cancelEvaluation);
+    QShortcut* diagnosticsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    QObject::connect(diagnosticsShortcut, &QShortcut::activated, this, &MainWindow::showDiagnostics);
+
+    // Live preview line under the entry, in both display layouts
+    previewWatcher = new QFutureWatcher<EvalResult>(this);
+    QObject::connect(previewWatcher, &QFutureWatcher<EvalResult>::finished, this, &MainWindow::previewFinished);
+    auto makePreviewLabel = [this](QVBoxLayout* layout) {
+        QLabel* label = new QLabel(this);
+        label->setStyleSheet("color: gray;");
+        label->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        layout->addWidget(label);
+        return label;
+    };
+    previewLabel = makePreviewLabel(ui->displayLayout);
+    previewLabel_2 = makePreviewLabel(ui->displayLayout_2);
+    previewLabel_3 = makePreviewLabel(ui->displayLayout_3);
+
+    // The number shown in every base at once, under the Programmer display
+    baseLabel_3 = new QLabel(this);
+    baseLabel_3->setStyleSheet("color: gray; font-family: monospace;");
+    baseLabel_3->setWordWrap(true);
+    baseLabel_3->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    ui->displayLayout_3->addWidget(baseLabel_3);
+
+    busyTimer = new QTimer(this);
+    busyTimer->setSingleShot(true);
+    busyTimer->setInterval(150);
+    QObject::connect(busyTimer, &QTimer::timeout, this, [this] {
+        // disabling the keypad takes the focus from it; setBusy(false) gives it back
+        QWidget* focus = QApplication::focusWidget();
+        if (focus && ui->centralwidget->isAncestorOf(focus)) busyFocus = focus;
+        ui->centralwidget->setEnabled(false);
+        statusBar()->showMessage(tr("Calculating..."));
+        busyIndicator->show();
+        cancelButton->show();
+    });
 }
 
 MainWindow::~MainWindow()
 {
+    // the workers use `engine`; stop them before the members go away
+    evalCancel = true;
+    previewCancel = true;
+    evalWatcher->waitForFinished();
+    previewWatcher->waitForFinished();
     delete ui;
 }
 
+// While an evaluation runs the keypad ignores clicks, so the buffers the result
+// is written back to cannot change underneath it. Most results arrive within
+// busyTimer's interval; only when it fires is the keypad visibly disabled and
+// the indicator and the Cancel button shown.
+void MainWindow::setBusy(bool busy) {
+    for (QPushButton* button : ui->centralwidget->findChildren<QPushButton*>())
+        button->blockSignals(busy);
+    if (busy) {
+        busyTimer->start();
+        return;
+    }
+    busyTimer->stop();
+    ui->centralwidget->setEnabled(true);
+    if (busyFocus) busyFocus->setFocus();
+    busyFocus = nullptr;
+    busyIndicator->hide();
+    cancelButton->hide();
+    statusBar()->clearMessage();
+}
+
+void MainWindow::cancelEvaluation() {
+    if (evalWatcher->isRunning()) evalCancel = true;
+}
+
 // Function Implementation for when Menu Bar actions are triggered
 
 // View
 void MainWindow::on_actionBasic_triggered()
 {
     // Switch to Basic View
+    setProgrammerMode(false);
     ui->calculator_views->setCurrentIndex(0);
 }
 void MainWindow::on_actionScientific_triggered()
 {
     // Switch to Scientific View
+    setProgrammerMode(false);
     ui->calculator_views->setCurrentIndex(1);
 }
 void MainWindow::on_actionProgrammer_triggered()
 {
     // Switch to Programmer View
+    setProgrammerMode(true);
     ui->calculator_views->setCurrentIndex(2);
 }
 
+// The Programmer view reads the entry as a word in prog_radix and the other
+// views as a decimal, so moving between them starts from AC
+void MainWindow::setProgrammerMode(bool on) {
+    if (on == programmer_mode) return;
+    cancelEvaluation();
+    evalWatcher->waitForFinished();
+    stopPreview();
+    programmer_mode = on;
+    on_button_ac_clicked();
+}
+
 // Converter
 void MainWindow::openConverter()
 {
@@ -1391,7 +723,7 @@ void MainWindow::on_actionAbout_triggered()
 // Buttons in all Views
 
 void MainWindow::on_button_ac_clicked() {
-    numeric_input_buffer = { "0" };
+    numeric_input_buffer = "0";
     equation_buffer.clear();
     dp_used = false;
     number_is_negative = false;
@@ -1403,11 +735,11 @@ void MainWindow::on_button_ac_clicked() {
 
 void MainWindow::on_button_backspace_clicked() {
     if (numeric_input_buffer.size() > 1) {
-        if (numeric_input_buffer.back() == ".") dp_used = false;
+        if (numeric_input_buffer.back() == '.') dp_used = false;
         numeric_input_buffer.pop_back();
     }
     else {
-        numeric_input_buffer = { "0" };
+        numeric_input_buffer = "0";
         new_number = true;
     }
     updateDisplay();
@@ -1434,11 +766,11 @@ void MainWindow::appendDigit(const std::string& digit)
     //
 
     // Avoid leading zeros unless there's a decimal point
-    if (numeric_input_buffer.size() == 1 && numeric_input_buffer[0] == "0" && digit != ".") {
+    if (numeric_input_buffer == "0" && digit != ".") {
         numeric_input_buffer.clear();
     }
 
-    numeric_input_buffer.push_back(digit);
+    numeric_input_buffer += digit;
     updateDisplay();
 }
 void MainWindow::on_button_n0_clicked() { appendDigit("0"); }
@@ -1452,8 +784,154 @@ void MainWindow::on_button_n7_clicked() { appendDigit("7"); }
 void MainWindow::on_button_n8_clicked() { appendDigit("8"); }
 void MainWindow::on_button_n9_clicked() { appendDigit("9"); }
 
-static inline bool isOpToken(const std::string& t) {
-    return t == "+" || t == "-" || t == "*" || t == "/" || t == "mod"; // ← add "mod"
+static inline bool isOpToken(const Token& t) {
+    return t.isOperator() && !t.isOperator('^');   // + - * /, mod and the word operators
+}
+
+// The expression "=" would evaluate right now: the entry committed, open
+// parentheses closed and a trailing operator dropped
+static std::vector<Token> pending_tokens() {
+    std::vector<Token> toks = equation_buffer;
+    if (!new_number) commit_entry(toks);
+    for (int i = 0; i < open_parens; ++i) toks.push_back(")");
+    if (!toks.empty() && isOpToken(toks.back())) toks.pop_back();
+    if (toks.empty()) commit_entry(toks);   // fallback to entry only
+    return toks;
+}
+
+void MainWindow::schedulePreview() {
+    if (evalWatcher->isRunning()) return;
+    if (previewWatcher->isRunning()) {
+        // superseded: let it unwind, previewFinished() starts the next one
+        previewCancel = true;
+        previewStale = true;
+        return;
+    }
+
+    std::vector<Token> toks = pending_tokens();
+    bool computes = std::any_of(toks.begin(), toks.end(), [](const Token& t) {
+        return t.kind == TokenKind::Operator || t.kind == TokenKind::Function;
+    });
+    if (!computes) {   // a bare number or ANS previews itself
+        showPreview(QString());
+        return;
+    }
+    if (programmer_mode) {   // words take microseconds: no worker needed
+        WordResult r = evaluate_words(toks, word_options());
+        showPreview(r.ok() ? "= " + QString::fromStdString(word_display(r.value)) : QString());
+        return;
+    }
+
+    EvalOptions opts;   // as on "=", so that "=" finds the program compiled
+    opts.angle_unit = g_angle_unit;
+    opts.ans = last_answer;
+    opts.exact = true;
+    opts.ans_is_exact = last_answer_is_exact;
+    opts.exact_ans = last_answer_exact;
+    opts.cancel = &previewCancel;
+    opts.time_limit_ms = 1000;   // speculative work: "=" may take longer, a preview may not
+    previewCancel = false;
+    if (trace::compiled_in) previewStartNs = trace::now_ns();
+    previewWatcher->setFuture(QtConcurrent::run([this, toks, opts] {
+        return engine.evaluate(toks, opts);
+    }));
+}
+
+void MainWindow::previewFinished() {
+    if (previewStale) {
+        previewStale = false;
+        schedulePreview();
+        return;
+    }
+    if (trace::compiled_in) {
+        static const int latency = trace::stage("preview latency");   // edit to preview shown
+        trace::record(latency, previewStartNs, trace::now_ns());
+    }
+    EvalResult result = previewWatcher->result();
+    if (!result.ok()) {   // cancelled, or nothing worth showing (errors wait for "=")
+        showPreview(QString());
+        return;
+    }
+    showPreview("= " + QString::fromStdString(format_for_display(result.value, 20, 20)));
+}
+
+void MainWindow::stopPreview() {
+    previewCancel = true;
+    previewStale = false;
+    previewWatcher->waitForFinished();   // cancelling takes well under a millisecond
+    showPreview(QString());
+}
+
+void MainWindow::showPreview(const QString& text) {
+    previewLabel->setText(text);
+    previewLabel_2->setText(text);
+    previewLabel_3->setText(text);
+}
+
+void MainWindow::showDiagnostics() {
+    if (!diagnosticsDialog) {
+        diagnosticsDialog = new QDialog(this);
+        diagnosticsDialog->setWindowTitle(tr("Diagnostics"));
+        diagnosticsDialog->resize(560, 360);
+        diagnosticsText = new QPlainTextEdit(diagnosticsDialog);
+        diagnosticsText->setReadOnly(true);
+        diagnosticsText->setStyleSheet("font-family: monospace;");
+
+        QPushButton* refresh = new QPushButton(tr("Refresh"), diagnosticsDialog);
+        QPushButton* reset = new QPushButton(tr("Reset"), diagnosticsDialog);
+        QPushButton* save = new QPushButton(tr("Save Trace..."), diagnosticsDialog);
+        QObject::connect(refresh, &QPushButton::clicked, this, &MainWindow::refreshDiagnostics);
+        QObject::connect(reset, &QPushButton::clicked, this, [this] {
+            trace::reset();
+            refreshDiagnostics();
+        });
+        QObject::connect(save, &QPushButton::clicked, this, [this] {
+            QString path = QFileDialog::getSaveFileName(diagnosticsDialog, tr("Save Trace"),
+                "numeric-engine-trace.json", tr("Trace files (*.json)"));
+            if (!path.isEmpty() && !trace::write_chrome_trace(path.toStdString()))
+                diagnosticsText->setPlainText(tr("Could not write %1").arg(path));
+        });
+
+        QHBoxLayout* buttons = new QHBoxLayout();
+        buttons->addStretch();
+        buttons->addWidget(refresh);
+        buttons->addWidget(reset);
+        buttons->addWidget(save);
+        QVBoxLayout* layout = new QVBoxLayout(diagnosticsDialog);
+        layout->addWidget(diagnosticsText);
+        layout->addLayout(buttons);
+        save->setEnabled(trace::compiled_in);
+        reset->setEnabled(trace::compiled_in);
+    }
+    refreshDiagnostics();
+    diagnosticsDialog->show();
+    diagnosticsDialog->raise();
+    diagnosticsDialog->activateWindow();
+}
+
+void MainWindow::refreshDiagnostics() {
+    if (!trace::compiled_in) {
+        diagnosticsText->setPlainText(tr("Stage timings are not compiled in.\n"
+            "Configure with -DNUMERIC_ENGINE_TRACE=ON to record them."));
+        return;
+    }
+
+    std::string text;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-18s %10s %12s %12s %12s\n", "stage", "calls", "avg us", "max us", "total ms");
+    text += line;
+    for (const trace::StageStats& st : trace::stage_stats()) {
+        double avg = st.calls ? st.total_ns / 1e3 / st.calls : 0.0;
+        std::snprintf(line, sizeof(line), "%-18s %10llu %12.1f %12.1f %12.2f\n", st.name.c_str(), st.calls,
+            avg, st.max_ns / 1e3, st.total_ns / 1e6);
+        text += line;
+    }
+    text += "\n";
+    for (const trace::CounterStats& c : trace::counter_stats()) {
+        std::snprintf(line, sizeof(line), "%-24s %12lld\n", c.name.c_str(), c.value);
+        text += line;
+    }
+    diagnosticsText->setPlainText(QString::fromStdString(text));
 }
 
 void MainWindow::appendOperator(const std::string& op) {
@@ -1472,10 +950,7 @@ void MainWindow::appendOperator(const std::string& op) {
 
     // Commit current number if present
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const std::string& c : numeric_input_buffer) equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
     }
 
     // Collapse any trailing operators; keep only the last one pressed
@@ -1503,6 +978,7 @@ void MainWindow::appendOperator(const std::string& op) {
         // Only refresh the equation line (e.g. "Ans +").
         ui->equationLabel->setText(pretty_equation_from_tokens(equation_buffer));
         ui->equationLabel_2->setText(pretty_equation_from_tokens(equation_buffer));
+        ui->equationLabel_3->setText(pretty_equation_from_tokens(equation_buffer));
     }
     else {
         // Normal behavior: update both equation and current-entry display.
@@ -1517,11 +993,10 @@ void MainWindow::on_button_divide_clicked() { appendOperator("/"); }
 void MainWindow::on_button_decimal_point_clicked() {
     if (!dp_used) {
         if (new_number) {
-            numeric_input_buffer.clear();
-            numeric_input_buffer.push_back("0");
+            numeric_input_buffer = "0";
             new_number = false;
         }
-        numeric_input_buffer.push_back(".");
+        numeric_input_buffer += '.';
         dp_used = true;
         updateDisplay();
     }
@@ -1541,11 +1016,7 @@ void MainWindow::on_button_ans_clicked() {
 
     // Commit any currently typed number first
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const auto& c : numeric_input_buffer)
-            equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
 
@@ -1565,62 +1036,77 @@ void MainWindow::on_button_ans_clicked() {
 }
 
 void MainWindow::on_button_equals_clicked() {
-    std::vector<std::string> eval_tokens = equation_buffer;
+    if (evalWatcher->isRunning()) return;   // one evaluation at a time
+    stopPreview();
 
-    // commit current entry
-    if (!new_number) {
-        if (number_is_negative) { eval_tokens.push_back("("); eval_tokens.push_back("-"); }
-        for (const auto& c : numeric_input_buffer) eval_tokens.push_back(c);
-        if (number_is_negative) eval_tokens.push_back(")");
-    }
-
-    // auto-close
-    for (int i = 0; i < open_parens; ++i) eval_tokens.push_back(")");
-    open_parens = 0;
-
-    // strip trailing op
-    auto isOpToken = [](const std::string& t) {
-        return t == "+" || t == "-" || t == "*" || t == "/" || t == "mod"; // ← add "mod"
-        };
-    if (!eval_tokens.empty() && isOpToken(eval_tokens.back()))
-        eval_tokens.pop_back();
-
-    // fallback to entry only
-    if (eval_tokens.empty()) {
-        if (number_is_negative) { eval_tokens.push_back("("); eval_tokens.push_back("-"); }
-        for (const auto& c : numeric_input_buffer) eval_tokens.push_back(c);
-        if (number_is_negative) eval_tokens.push_back(")");
-    }
+    // commit current entry, auto-close, strip trailing op
+    std::vector<Token> eval_tokens = pending_tokens();
 
     // show pretty (with sin, √, ×, ÷, etc.)
     ui->equationLabel->setText(pretty_equation_from_tokens(eval_tokens) + " =");
     ui->equationLabel_2->setText(pretty_equation_from_tokens(eval_tokens) + " =");
+    ui->equationLabel_3->setText(pretty_equation_from_tokens(eval_tokens) + " =");
 
-    // make evaluator-safe
-    eval_tokens = expandDisplayFuncs(eval_tokens);
+    if (programmer_mode) {   // words take microseconds: evaluated right here
+        wordEvaluationFinished(evaluate_words(eval_tokens, word_options()));
+        return;
+    }
 
-    // flatten
-    std::string final_eq;
-    for (const auto& t : eval_tokens) final_eq += t;
+    // evaluate on a worker (compile, optimize, run); evaluationFinished()
+    // picks up the result
+    EvalOptions opts;
+    opts.angle_unit = g_angle_unit;
+    opts.ans = last_answer;
+    opts.exact = true;   // + - * / and integer powers come out exact: 1/3*3 is 1
+    opts.ans_is_exact = last_answer_is_exact;
+    opts.exact_ans = last_answer_exact;
+    opts.cancel = &evalCancel;
+    evalCancel = false;
+    if (trace::compiled_in) evalStartNs = trace::now_ns();
+    setBusy(true);
+    evalWatcher->setFuture(QtConcurrent::run([this, eval_tokens, opts] {
+        return engine.evaluate(eval_tokens, opts);
+    }));
+}
+
+void MainWindow::evaluationFinished() {
+    if (trace::compiled_in) {
+        static const int latency = trace::stage("= latency");   // click to result, across threads
+        trace::record(latency, evalStartNs, trace::now_ns());
+    }
+    setBusy(false);
+    EvalResult result = evalWatcher->result();
+    if (result.status == EvalStatus::Cancelled) {
+        // nothing was computed: keep ANS and the buffers as they were
+        ui->answerInputLabel->setText(tr("Cancelled"));
+        ui->answerInputLabel_2->setText(tr("Cancelled"));
+        return;
+    }
 
-    // evaluate
-    BigFloat res = evaluateFromInfix(final_eq);
+    const BigFloat& res = result.value;
+    const bool div0 = (result.status == EvalStatus::DivideByZero);
+    last_answer.set_prec(res.get_prec());   // keep every digit the engine worked out
     last_answer = res;
+    last_answer_is_exact = result.exact;
+    if (result.exact) last_answer_exact = result.rational;
     just_evaluated = true;
 
-    std::string raw = mpf_to_string(res, 80); // raw, high digits
-    std::string disp = g_eval_div0 ? "undefined" : format_for_display(res, 20, 20);
-
     // show to user
-    if (!last_eval_error.empty()) {
-        ui->answerInputLabel->setText(QString::fromStdString(last_eval_error));
-        ui->answerInputLabel_2->setText(QString::fromStdString(last_eval_error));
-        last_eval_error.clear();
+    if (result.status == EvalStatus::DomainError || result.status == EvalStatus::SyntaxError
+        || result.status == EvalStatus::BudgetExceeded) {
+        ui->answerInputLabel->setText(QString::fromStdString(result.error));
+        ui->answerInputLabel_2->setText(QString::fromStdString(result.error));
         return;
     }
-    else {
-        ui->answerInputLabel->setText(QString::fromStdString(disp));
-        ui->answerInputLabel_2->setText(QString::fromStdString(disp));
+    DecimalForm digits(res);   // one conversion for the display and the entry
+    std::string disp = div0 ? "undefined" : digits.display(20, 20);
+    ui->answerInputLabel->setText(QString::fromStdString(disp));
+    ui->answerInputLabel_2->setText(QString::fromStdString(disp));
+    if (result.exact) {
+        // a fraction whose decimals do not end is also shown as one
+        std::string exact = format_exact(result.rational);
+        if (exact.find('/') != std::string::npos && exact.size() <= 24)
+            showPreview("= " + QString::fromStdString(exact));
     }
 
     //// keep raw for chaining
@@ -1635,16 +1121,17 @@ void MainWindow::on_button_equals_clicked() {
 
     // keep symbolic ANS for chaining (displayed as "Ans"); evaluator will
     // replace ANS with the numeric value when needed.
-    if (!g_eval_div0) {
+    if (!div0) {
         equation_buffer.clear();
         equation_buffer.push_back("ANS");
     }
     else {
         equation_buffer = { "0" };
     }
+    open_parens = 0;   // any unclosed '(' went with the old buffer
 
-    // also keep raw in entry
-    numeric_input_buffer = { g_eval_div0 ? std::string("0") : raw };
+    // also keep the raw, high digits in the entry
+    numeric_input_buffer = div0 ? std::string("0") : digits.plain(80);
 
     number_is_negative = false;
     dp_used = false;
@@ -1654,6 +1141,51 @@ void MainWindow::on_button_equals_clicked() {
     new_number = true;
 }
 
+// evaluationFinished() for the Programmer view
+void MainWindow::wordEvaluationFinished(const WordResult& result) {
+    just_evaluated = true;
+    if (result.status == EvalStatus::SyntaxError) {
+        ui->answerInputLabel_3->setText(QString::fromStdString(result.error));
+        return;
+    }
+    const bool div0 = (result.status == EvalStatus::DivideByZero);
+    if (!div0) prog_answer = result.value;
+    ui->answerInputLabel_3->setText(div0 ? QString("undefined") : QString::fromStdString(word_display(result.value)));
+
+    // keep symbolic ANS for chaining, and the result in the entry
+    if (!div0) {
+        equation_buffer.clear();
+        equation_buffer.push_back("ANS");
+        load_entry_from_word(result.value);
+    }
+    else {
+        equation_buffer = { "0" };
+        numeric_input_buffer = "0";
+        number_is_negative = false;
+    }
+    open_parens = 0;
+
+    just_evaluated_full = true;
+    new_number = true;
+    updateBaseDisplay();
+}
+
+// HEX, DEC, OCT and BIN of the number in the entry. Each is rendered from the
+// word itself, and only when the number changed: keys that leave it alone
+// (operators, parentheses) cost nothing here.
+void MainWindow::updateBaseDisplay() {
+    if (!programmer_mode) return;
+    WordInt v = current_entry_to_word();
+    if (bases_valid && v == bases_shown) return;
+    bases_shown = v;
+    bases_valid = true;
+
+    std::string text = "HEX  " + group_digits(v.toString(16), 4)
+        + "\nDEC  " + group_digits(v.toString(10, true), 3)
+        + "\nOCT  " + group_digits(v.toString(8), 3)
+        + "\nBIN  " + group_digits(v.toString(2), 4);
+    baseLabel_3->setText(QString::fromStdString(text));
+}
 
 void MainWindow::on_button_memory_add_clicked() {
     // M+: memory += current_entry
@@ -1692,10 +1224,7 @@ void MainWindow::on_button_memory_clear_clicked() {
 void MainWindow::on_button_parentheses_left_clicked() {
     auto commit_current_number = [&]() {
         if (!new_number) {
-            if (number_is_negative) equation_buffer.push_back("(");
-            if (number_is_negative) equation_buffer.push_back("-");
-            for (const std::string& c : numeric_input_buffer) equation_buffer.push_back(c);
-            if (number_is_negative) equation_buffer.push_back(")");
+            commit_entry(equation_buffer);
         }
         };
 
@@ -1705,12 +1234,6 @@ void MainWindow::on_button_parentheses_left_clicked() {
         new_number = true; dp_used = false; number_is_negative = false;
         };
 
-    auto lastChar = [&]() -> char {
-        if (equation_buffer.empty()) return 0;
-        const std::string& s = equation_buffer.back();
-        return s.empty() ? 0 : s.back();
-        };
-
     // If a number is currently being typed, do implicit multiplication: number * (
     if (!new_number) {
         commit_current_number();
@@ -1720,10 +1243,10 @@ void MainWindow::on_button_parentheses_left_clicked() {
         return;
     }
 
-    char lc = lastChar();
-    bool afterOpOrStart =
-        (lc == 0 || lc == '(' || lc == '+' || lc == '-' ||
-            lc == '*' || lc == '/' || lc == '^' || lc == ',');
+    bool afterOpOrStart = equation_buffer.empty()
+        || equation_buffer.back().kind == TokenKind::LParen
+        || equation_buffer.back().kind == TokenKind::Comma
+        || equation_buffer.back().isOperator();
 
     if (afterOpOrStart) {
         push_open();
@@ -1740,11 +1263,7 @@ void MainWindow::on_button_parentheses_right_clicked() {
     if (open_parens > 0) {
         // Add current number before closing
         if (!new_number) {
-            if (number_is_negative) equation_buffer.push_back("(");
-            if (number_is_negative) equation_buffer.push_back("-");
-            for (std::string c : numeric_input_buffer)
-                equation_buffer.push_back(c);
-            if (number_is_negative) equation_buffer.push_back(")");
+            commit_entry(equation_buffer);
         }
 
         equation_buffer.push_back(")");
@@ -1769,8 +1288,6 @@ void MainWindow::on_angleUnitSelection_activated(int i) {
 }
 
 void MainWindow::on_button_absolute_value_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after abs() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -1783,7 +1300,7 @@ void MainWindow::on_button_absolute_value_clicked() {
     open_parens++; // track open '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance
     }
@@ -1810,11 +1327,7 @@ void MainWindow::on_button_constant_e_clicked() {
 
     // If a number is currently being typed, commit it to the equation
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const auto& c : numeric_input_buffer)
-            equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
 
@@ -1843,11 +1356,7 @@ void MainWindow::on_button_constant_pi_clicked() {
 
     // Commit current number if the user was typing one
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const auto& c : numeric_input_buffer)
-            equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
 
@@ -1869,8 +1378,6 @@ void MainWindow::on_button_constant_pi_clicked() {
 }
 
 void MainWindow::on_button_cosine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after sin() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -1883,7 +1390,7 @@ void MainWindow::on_button_cosine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -1908,9 +1415,7 @@ void MainWindow::on_button_exponent_scientific_clicked() {
     }
     // Commit current number if present
     if (!new_number) {
-        if (number_is_negative) { equation_buffer.push_back("("); equation_buffer.push_back("-"); }
-        for (const auto& c : numeric_input_buffer) equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
     else if (equation_buffer.empty()) {
@@ -1948,11 +1453,7 @@ void MainWindow::on_button_exponential_clicked()
 
     // Commit current number before inserting ^
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const auto& c : numeric_input_buffer)
-            equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
 
@@ -1989,8 +1490,6 @@ void MainWindow::on_button_exponential_clicked()
 //    updateDisplay();
 //}
 void MainWindow::on_button_exponential_base10_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the entire equation if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2002,20 +1501,8 @@ void MainWindow::on_button_exponential_base10_clicked() {
     equation_buffer.push_back("^");
 
     if (!new_number) {
-        // If the current entry is negative, wrap it in parentheses
-        if (number_is_negative || (!x.empty() && x[0] == '-')) {
-            equation_buffer.push_back("(");
-            equation_buffer.push_back("-");
-            for (size_t i = 1; i < x.size(); ++i) {
-                equation_buffer.push_back(std::string(1, x[i]));
-            }
-            equation_buffer.push_back(")");
-        }
-        else {
-            for (char c : x) {
-                equation_buffer.push_back(std::string(1, c));
-            }
-        }
+        // a negative entry is wrapped in parentheses
+        commit_entry(equation_buffer);
     }
 
     new_number = true;
@@ -2028,8 +1515,6 @@ void MainWindow::on_button_exponential_base10_clicked() {
     }
 }
 void MainWindow::on_button_exponential_natural_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the entire equation if we just finished "="
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
         equation_buffer.clear();
@@ -2040,20 +1525,8 @@ void MainWindow::on_button_exponential_natural_clicked() {
     equation_buffer.push_back("^");
 
     if (!new_number) {
-        // If the current entry is negative, wrap it in parentheses
-        if (number_is_negative || (!x.empty() && x[0] == '-')) {
-            equation_buffer.push_back("(");
-            equation_buffer.push_back("-");
-            for (size_t i = 1; i < x.size(); ++i) {
-                equation_buffer.push_back(std::string(1, x[i]));
-            }
-            equation_buffer.push_back(")");
-        }
-        else {
-            for (char c : x) {
-                equation_buffer.push_back(std::string(1, c));
-            }
-        }
+        // a negative entry is wrapped in parentheses
+        commit_entry(equation_buffer);
     }
 
     new_number = true;
@@ -2086,7 +1559,7 @@ void MainWindow::on_button_factorial_clicked() {
     open_parens++; // track open '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance
     }
@@ -2099,11 +1572,7 @@ void MainWindow::on_button_factorial_clicked() {
         return;
     }
 
-    BigFloat r = 1;
-    for (long long i = 2; i <= n; ++i)
-        r *= BigFloat(static_cast<double>(i)); // fixed
-
-    // load_entry_from_big(r);
+    // the factorial itself is computed by the engine on "=", off the GUI thread
 
     new_number = true;
     number_is_negative = false;
@@ -2118,8 +1587,6 @@ void MainWindow::on_button_factorial_clicked() {
     }
 }
 void MainWindow::on_button_hyp_cosine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after cosh() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2132,7 +1599,7 @@ void MainWindow::on_button_hyp_cosine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2150,8 +1617,6 @@ void MainWindow::on_button_hyp_cosine_clicked() {
     }
 }
 void MainWindow::on_button_hyp_sine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after sinh() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2164,7 +1629,7 @@ void MainWindow::on_button_hyp_sine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2182,8 +1647,6 @@ void MainWindow::on_button_hyp_sine_clicked() {
     }
 }
 void MainWindow::on_button_hyp_tangent_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after tanh() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2196,7 +1659,7 @@ void MainWindow::on_button_hyp_tangent_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2214,8 +1677,6 @@ void MainWindow::on_button_hyp_tangent_clicked() {
     }
 }
 void MainWindow::on_button_inverse_cosine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after acos() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2228,7 +1689,7 @@ void MainWindow::on_button_inverse_cosine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2246,14 +1707,13 @@ void MainWindow::on_button_inverse_cosine_clicked() {
     }
 }
 void MainWindow::on_button_inverse_hyp_sine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) { equation_buffer.clear(); just_evaluated_full = false; }
 
     equation_buffer.push_back("FUNC_ASINH");
     equation_buffer.push_back("(");
     open_parens++;
     if (!new_number) {                 // there is a number ready in the entry buffer
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--;
     }
@@ -2268,14 +1728,13 @@ void MainWindow::on_button_inverse_hyp_sine_clicked() {
 }
 
 void MainWindow::on_button_inverse_hyp_cosine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) { equation_buffer.clear(); just_evaluated_full = false; }
 
     equation_buffer.push_back("FUNC_ACOSH");
     equation_buffer.push_back("(");
     open_parens++;
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--;
     }
@@ -2290,14 +1749,13 @@ void MainWindow::on_button_inverse_hyp_cosine_clicked() {
 }
 
 void MainWindow::on_button_inverse_hyp_tangent_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) { equation_buffer.clear(); just_evaluated_full = false; }
 
     equation_buffer.push_back("FUNC_ATANH");
     equation_buffer.push_back("(");
     open_parens++;
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--;
     }
@@ -2311,8 +1769,6 @@ void MainWindow::on_button_inverse_hyp_tangent_clicked() {
     }
 }
 void MainWindow::on_button_inverse_sine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after asin() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2325,7 +1781,7 @@ void MainWindow::on_button_inverse_sine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2343,8 +1799,6 @@ void MainWindow::on_button_inverse_sine_clicked() {
     }
 }
 void MainWindow::on_button_inverse_tangent_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after atan() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2357,7 +1811,7 @@ void MainWindow::on_button_inverse_tangent_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2399,8 +1853,6 @@ void MainWindow::on_button_logarithm_common_clicked() {
 }
 */
 void MainWindow::on_button_logarithm_common_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after log() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2413,7 +1865,7 @@ void MainWindow::on_button_logarithm_common_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2455,8 +1907,6 @@ void MainWindow::on_button_logarithm_natural_clicked() {
 }
 */
 void MainWindow::on_button_logarithm_natural_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after log() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2469,7 +1919,7 @@ void MainWindow::on_button_logarithm_natural_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2487,7 +1937,7 @@ void MainWindow::on_button_logarithm_natural_clicked() {
     }
 }
 void MainWindow::on_button_modulus_clicked() {
-    appendOperator(" mod ");  // same flow as +, -, *, /
+    appendOperator("mod");  // same flow as +, -, *, /
 }
 //void MainWindow::on_button_percent_clicked() {
 //    // basic %: x -> x/100
@@ -2509,8 +1959,6 @@ void MainWindow::on_button_modulus_clicked() {
 //    updateDisplay();
 //}
 void MainWindow::on_button_percent_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after %() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2523,7 +1971,7 @@ void MainWindow::on_button_percent_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2577,8 +2025,6 @@ void MainWindow::on_button_random_number_clicked() {
     }
 }
 void MainWindow::on_button_reciprocal_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after reciprocal() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2591,7 +2037,7 @@ void MainWindow::on_button_reciprocal_clicked() {
     open_parens++; // track open '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance
     }
@@ -2609,8 +2055,6 @@ void MainWindow::on_button_reciprocal_clicked() {
     }
 }
 void MainWindow::on_button_sine_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after sin() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2623,7 +2067,7 @@ void MainWindow::on_button_sine_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2641,18 +2085,13 @@ void MainWindow::on_button_sine_clicked() {
     }
 }
 void MainWindow::on_button_square_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
         just_evaluated_full = false;
     }
 
     // If user has just typed a number, commit it to the equation buffer
     if (!new_number) {
-        if (number_is_negative) equation_buffer.push_back("(");
-        if (number_is_negative) equation_buffer.push_back("-");
-        for (const auto& c : numeric_input_buffer) equation_buffer.push_back(c);
-        if (number_is_negative) equation_buffer.push_back(")");
+        commit_entry(equation_buffer);
         new_number = true;
     }
 
@@ -2669,8 +2108,6 @@ void MainWindow::on_button_square_clicked() {
     }
 }
 void MainWindow::on_button_square_root_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after sin() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2683,7 +2120,7 @@ void MainWindow::on_button_square_root_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2701,8 +2138,6 @@ void MainWindow::on_button_square_root_clicked() {
     }
 }
 void MainWindow::on_button_tangent_clicked() {
-    std::string x = concat_numeric_input_buffer_content();
-
     // Prevent clearing the equation after sin() if we just finished "="
     // Prevent previous number from persisting in function 
     bool was_full_eval = just_evaluated_full; if (just_evaluated_full) {
@@ -2715,7 +2150,7 @@ void MainWindow::on_button_tangent_clicked() {
     open_parens++; // keep track of unclosed '('
 
     if (!new_number) {
-        equation_buffer.push_back(x);
+        commit_entry(equation_buffer);
         equation_buffer.push_back(")");
         open_parens--; // balance parentheses
     }
@@ -2740,7 +2175,7 @@ void MainWindow::on_button_x_th_root_clicked() {
     equation_buffer.push_back("FUNC_XROOT");
     equation_buffer.push_back("(");
     open_parens++;
-    equation_buffer.push_back(x);
+    commit_entry(equation_buffer);
     equation_buffer.push_back(","); // comma separates x and y inside parentheses
     // Wait for user to enter the next number (the radicand y)
 
@@ -2765,58 +2200,100 @@ void MainWindow::on_button_x_th_root_clicked() {
 
 void MainWindow::on_button_ascii_clicked() {
 }
-void MainWindow::on_button_base_bin_clicked() {
-}
-void MainWindow::on_button_base_dec_clicked() {
-}
-void MainWindow::on_button_base_hex_clicked() {
-}
-void MainWindow::on_button_base_oct_clicked() {
-}
-void MainWindow::on_button_bit_rotate_left_clicked() {
-}
-void MainWindow::on_button_bit_rotate_right_clicked() {
-}
-void MainWindow::on_button_bit_shift_left_clicked() {
-}
-void MainWindow::on_button_bit_shift_right_clicked() {
+void MainWindow::on_button_base_bin_clicked() { setRadix(2); }
+void MainWindow::on_button_base_dec_clicked() { setRadix(10); }
+void MainWindow::on_button_base_hex_clicked() { setRadix(16); }
+void MainWindow::on_button_base_oct_clicked() { setRadix(8); }
+
+// Switch the base numbers are typed and shown in. The entry and the numbers
+// already in the equation are rewritten, so every value stays the same.
+void MainWindow::setRadix(int radix) {
+    if (radix != prog_radix) {
+        WordInt entry = current_entry_to_word();
+        for (Token& t : equation_buffer) {
+            if (!t.isNumber()) continue;
+            WordInt v(prog_width);
+            WordInt::parse(prog_width, t.text, prog_radix, v);
+            t.text = v.toString(radix);
+        }
+        prog_radix = radix;
+        load_entry_from_word(entry);
+        updateDisplay();
+    }
+    showRadix();
 }
-void MainWindow::on_button_bitwise_and_clicked() {
+
+// Check the current base's button and enable only its digits
+void MainWindow::showRadix() {
+    ui->base_hex->setChecked(prog_radix == 16);
+    ui->base_dec->setChecked(prog_radix == 10);
+    ui->base_oct->setChecked(prog_radix == 8);
+    ui->base_bin->setChecked(prog_radix == 2);
+
+    QPushButton* digits[] = {
+        ui->n0_3, ui->n1_3, ui->n2_3, ui->n3_3, ui->n4_3, ui->n5_3, ui->n6_3, ui->n7_3,
+        ui->n8_3, ui->n9_3, ui->i_a, ui->i_b, ui->i_c, ui->i_d, ui->i_e, ui->i_f,
+    };
+    for (int d = 0; d < 16; ++d) digits[d]->setEnabled(d < prog_radix);
 }
-void MainWindow::on_button_bitwise_not_clicked() {
+
+// NOT and the rotations act at once on the number shown, like negate
+void MainWindow::transformEntry(WordInt (*f)(const WordInt&)) {
+    if (just_evaluated_full) {   // go on from the result itself, not from "Ans ="
+        equation_buffer.clear();
+        just_evaluated_full = false;
+    }
+    just_evaluated = false;
+    load_entry_from_word(f(current_entry_to_word()));
+    new_number = false;
+    updateDisplay();
 }
-void MainWindow::on_button_bitwise_or_clicked() {
+
+static WordInt rotate_left_1(const WordInt& v) {
+    WordInt r(v.width());
+    word_apply(WordOp::Rol, v, WordInt(v.width(), 1), r);
+    return r;
 }
-void MainWindow::on_button_bitwise_xor_clicked() {
+static WordInt rotate_right_1(const WordInt& v) {
+    WordInt r(v.width());
+    word_apply(WordOp::Ror, v, WordInt(v.width(), 1), r);
+    return r;
 }
+
+void MainWindow::on_button_bit_rotate_left_clicked() { transformEntry(rotate_left_1); }
+void MainWindow::on_button_bit_rotate_right_clicked() { transformEntry(rotate_right_1); }
+void MainWindow::on_button_bit_shift_left_clicked() { appendOperator("LSH"); }
+void MainWindow::on_button_bit_shift_right_clicked() { appendOperator("RSH"); }
+void MainWindow::on_button_bitwise_and_clicked() { appendOperator("AND"); }
+void MainWindow::on_button_bitwise_not_clicked() { transformEntry(word_not); }
+void MainWindow::on_button_bitwise_or_clicked() { appendOperator("OR"); }
+void MainWindow::on_button_bitwise_xor_clicked() { appendOperator("XOR"); }
 void MainWindow::on_button_conv_clicked() {
 }
-void MainWindow::on_button_modulus_2_clicked() {
-}
+void MainWindow::on_button_modulus_2_clicked() { appendOperator("mod"); }
 void MainWindow::on_button_unicode_clicked() {
 }
-void MainWindow::on_button_i_a_clicked() {
-}
-void MainWindow::on_button_i_b_clicked() {
-}
-void MainWindow::on_button_i_c_clicked() {
-}
-void MainWindow::on_button_i_d_clicked() {
-}
-void MainWindow::on_button_i_e_clicked() {
-}
-void MainWindow::on_button_i_f_clicked() {
-}
+void MainWindow::on_button_i_a_clicked() { appendDigit("A"); }
+void MainWindow::on_button_i_b_clicked() { appendDigit("B"); }
+void MainWindow::on_button_i_c_clicked() { appendDigit("C"); }
+void MainWindow::on_button_i_d_clicked() { appendDigit("D"); }
+void MainWindow::on_button_i_e_clicked() { appendDigit("E"); }
+void MainWindow::on_button_i_f_clicked() { appendDigit("F"); }
 
 void MainWindow::on_wordlen_toggled() {
-    // TODO: add Word length selection logic here
-    /*
-        if:
-        wordlen_word->isChecked(): Word length is WORD, 16 bits
-        wordlen_dword->isChecked(): Word length is DWORD, 32 bits
-        wordlen_qword->isChecked(): Word length is QWORD, 64 bits
-        wordlen_byte->isChecked(): Word length is BYTE, 8 bits
-    */
+    WordLength len = ui->wordlen_byte->isChecked() ? WordLength::Byte
+        : ui->wordlen_word->isChecked() ? WordLength::Word
+        : ui->wordlen_dword->isChecked() ? WordLength::DWord
+        : WordLength::QWord;
+    unsigned width = static_cast<unsigned>(len);
+    if (width == prog_width) return;   // the button being switched off
+
+    // the entry and ANS keep their signed value, cut to the new length
+    WordInt entry = current_entry_to_word().resized(width);
+    prog_answer = prog_answer.resized(width);
+    prog_width = width;
+    if (programmer_mode) load_entry_from_word(entry);
+    updateDisplay();
 }
 
 // why did i make this
\ No newline at end of file
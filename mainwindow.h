@@ -2,21 +2,31 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QFutureWatcher>
+#include <QPointer>
 #include <gmp.h>
 #include <gmpxx.h>
 
+#include <atomic>
+#include <cstdint>
+
+#include "engine.h"
+
+class QDialog;
+class QLabel;
+class QPlainTextEdit;
+class QProgressBar;
+class QPushButton;
+class QTimer;
+class WordInt;
+struct WordResult;
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
     class MainWindow;
 }
 QT_END_NAMESPACE
 
-enum AngleUnit {
-    ANG_DEG = 0,
-    ANG_RAD = 1,
-    ANG_GRAD = 2
-};
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -143,8 +153,56 @@ private slots:
     void appendOperator(const std::string& op);
     void load_entry_from_big(const mpf_class& x);
 
+    // Asynchronous evaluation
+    void evaluationFinished();
+    void cancelEvaluation();
+    void previewFinished();
+
+    // Hidden diagnostics panel (Ctrl+Shift+D): stage timings from trace.h
+    void showDiagnostics();
+
 private:
     Ui::MainWindow* ui;
+    Engine engine;
     AngleUnit currentAngleUnit() const;
+
+    // "=" runs engine.evaluate on the global thread pool so the window keeps
+    // painting; only one evaluation is in flight at a time.
+    QFutureWatcher<EvalResult>* evalWatcher;
+    std::atomic<bool> evalCancel{ false };   // EvalOptions::cancel of the running evaluation
+    QTimer* busyTimer;                       // reveals the busy state once a result is overdue
+    QPointer<QWidget> busyFocus;             // where the focus was when the keypad was disabled
+    QProgressBar* busyIndicator;
+    QPushButton* cancelButton;
+    void setBusy(bool busy);
+
+    // Live preview: after every edit the pending expression is evaluated in
+    // the background and shown greyed out under the entry. A newer edit
+    // cancels the preview in flight; "=" stops it, as both share `engine`.
+    QFutureWatcher<EvalResult>* previewWatcher;
+    std::atomic<bool> previewCancel{ false };
+    bool previewStale = false;               // the buffers changed while a preview ran
+    QLabel* previewLabel;
+    QLabel* previewLabel_2;
+    QLabel* previewLabel_3;
+    uint64_t evalStartNs = 0;                // trace clock when "=" was pressed
+    uint64_t previewStartNs = 0;             // trace clock when the preview was started
+    void schedulePreview();
+    void stopPreview();
+    void showPreview(const QString& text);
+
+    // Programmer view (wordint.h): evaluated on the GUI thread, as words
+    // take microseconds
+    void setProgrammerMode(bool on);
+    void wordEvaluationFinished(const WordResult& result);
+    void transformEntry(WordInt (*f)(const WordInt&));
+    QLabel* baseLabel_3;                     // the entry in HEX, DEC, OCT and BIN
+    void updateBaseDisplay();
+    void setRadix(int radix);
+    void showRadix();
+
+    QDialog* diagnosticsDialog = nullptr;    // created on first use
+    QPlainTextEdit* diagnosticsText = nullptr;
+    void refreshDiagnostics();
 };
 #endif // MAINWINDOW_H
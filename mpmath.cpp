@@ -0,0 +1,765 @@
+#include "mpmath.h"
+
+#include <gmpxx.h>
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef mpf_class BigFloat;
+
+// Bits carried on top of the destination precision inside every kernel
+static const mp_bitcnt_t kGuard = 32;
+
+// x = m * 2^e with 0.5 <= |m| < 1; LONG_MIN for x == 0
+static long exponent2(const mpf_t x) {
+    if (mpf_sgn(x) == 0) return LONG_MIN;
+    long e = 0;
+    mpf_get_d_2exp(&e, x);
+    return e;
+}
+
+// Number of bits in |n|
+static mp_bitcnt_t bit_length(unsigned long n) {
+    mp_bitcnt_t b = 0;
+    while (n) { ++b; n >>= 1; }
+    return b;
+}
+
+// rop = x * 2^k for any sign of k
+static void mul_2exp_si(mpf_t rop, const mpf_t x, long k) {
+    if (k >= 0) mpf_mul_2exp(rop, x, static_cast<mp_bitcnt_t>(k));
+    else        mpf_div_2exp(rop, x, static_cast<mp_bitcnt_t>(-k));
+}
+
+// Integral value that fits in a long?
+static bool fits_long_integer(const mpf_t x, long& out) {
+    if (!mpf_integer_p(x) || !mpf_fits_slong_p(x)) return false;
+    out = mpf_get_si(x);
+    return true;
+}
+
+// ===== Constants =====
+
+// Binary splitting of S = sum_{k>=0} 1 / ((2k+1) q^(2k)) over terms [a, b):
+// S(a,b) = T / (B Q). atanh(1/q) = S / q.
+static void atanh_split(unsigned long q2, unsigned long a, unsigned long b,
+    mpz_class& B, mpz_class& Q, mpz_class& T)
+{
+    if (b - a == 1) {
+        B = 2 * a + 1;
+        Q = (a == 0) ? 1UL : q2;
+        T = 1;
+        return;
+    }
+    unsigned long m = a + (b - a) / 2;
+    mpz_class Bl, Ql, Tl, Br, Qr, Tr;
+    atanh_split(q2, a, m, Bl, Ql, Tl);
+    atanh_split(q2, m, b, Br, Qr, Tr);
+    T = Br * Qr * Tl + Bl * Tr;
+    B = Bl * Br;
+    Q = Ql * Qr;
+}
+
+// rop = atanh(1/q) for an integer q >= 2
+static void atanh_inv(mpf_t rop, unsigned long q) {
+    mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    unsigned long terms = static_cast<unsigned long>(wp / (2.0 * std::log2(static_cast<double>(q)))) + 2;
+
+    mpz_class B, Q, T;
+    atanh_split(q * q, 0, terms, B, Q, T);
+    Q *= B;
+    Q *= q;
+
+    BigFloat num(0, wp), den(0, wp);
+    mpf_set_z(num.get_mpf_t(), T.get_mpz_t());
+    mpf_set_z(den.get_mpf_t(), Q.get_mpz_t());
+    mpf_div(rop, num.get_mpf_t(), den.get_mpf_t());
+}
+
+void compute_ln2(mpf_t rop) {
+    // ln 2 = 18 atanh(1/26) - 2 atanh(1/4801) + 8 atanh(1/8749)
+    mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    BigFloat a(0, wp), b(0, wp), c(0, wp);
+    atanh_inv(a.get_mpf_t(), 26);
+    atanh_inv(b.get_mpf_t(), 4801);
+    atanh_inv(c.get_mpf_t(), 8749);
+    BigFloat r(0, wp);
+    r = 18 * a - 2 * b + 8 * c;
+    mpf_set(rop, r.get_mpf_t());
+}
+
+void compute_ln10(mpf_t rop) {
+    // ln 10 = 3 ln 2 + ln(10/8), and ln(10/8) = 2 atanh(1/9)
+    mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    BigFloat l2(0, wp), a(0, wp);
+    compute_ln2(l2.get_mpf_t());
+    atanh_inv(a.get_mpf_t(), 9);
+    BigFloat r(0, wp);
+    r = 3 * l2 + 2 * a;
+    mpf_set(rop, r.get_mpf_t());
+}
+
+// Chudnovsky: 1/pi = 12 sum_k (-1)^k (6k)! (A + B k) / ((3k)! k!^3 C^(3k + 3/2)),
+// summed by binary splitting over [a, b) into P, Q, T
+static void chudnovsky_split(unsigned long a, unsigned long b, mpz_class& P, mpz_class& Q, mpz_class& T) {
+    static const unsigned long A = 13591409, B = 545140134;
+    if (b - a == 1) {
+        if (a == 0) { P = 1; Q = 1; }
+        else {
+            P = 6 * a - 5;
+            P *= 2 * a - 1;
+            P *= 6 * a - 1;
+            Q = a;
+            Q *= a;
+            Q *= a;
+            Q *= 10939058860032000UL;   // 640320^3 / 24
+        }
+        T = P * (A + B * a);
+        if (a & 1) T = -T;
+        return;
+    }
+    unsigned long m = a + (b - a) / 2;
+    mpz_class Pl, Ql, Tl, Pr, Qr, Tr;
+    chudnovsky_split(a, m, Pl, Ql, Tl);
+    chudnovsky_split(m, b, Pr, Qr, Tr);
+    T = Qr * Tl + Pl * Tr;
+    P = Pl * Pr;
+    Q = Ql * Qr;
+}
+
+void compute_pi(mpf_t rop) {
+    // each term adds about 47.11 bits
+    mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    unsigned long terms = static_cast<unsigned long>(wp / 47.11) + 2;
+    mpz_class P, Q, T;
+    chudnovsky_split(0, terms, P, Q, T);
+
+    // pi = 426880 sqrt(10005) Q / T
+    BigFloat q(0, wp), t(0, wp), r(0, wp);
+    mpf_sqrt_ui(r.get_mpf_t(), 10005);
+    mpf_mul_ui(r.get_mpf_t(), r.get_mpf_t(), 426880);
+    mpf_set_z(q.get_mpf_t(), Q.get_mpz_t());
+    mpf_set_z(t.get_mpf_t(), T.get_mpz_t());
+    mpf_mul(r.get_mpf_t(), r.get_mpf_t(), q.get_mpf_t());
+    mpf_div(rop, r.get_mpf_t(), t.get_mpf_t());
+}
+
+// sum_{k=a+1}^{b} a!/k! = P / Q over [a, b)
+static void e_split(unsigned long a, unsigned long b, mpz_class& P, mpz_class& Q) {
+    if (b - a == 1) { P = 1; Q = b; return; }
+    unsigned long m = a + (b - a) / 2;
+    mpz_class Pl, Ql, Pr, Qr;
+    e_split(a, m, Pl, Ql);
+    e_split(m, b, Pr, Qr);
+    P = Pl * Qr + Pr;
+    Q = Ql * Qr;
+}
+
+void compute_e(mpf_t rop) {
+    mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    // smallest N with log2(N!) > wp
+    unsigned long terms = 2;
+    for (double bits = 1; bits <= static_cast<double>(wp); ++terms) bits += std::log2(static_cast<double>(terms));
+    mpz_class P, Q;
+    e_split(0, terms, P, Q);
+    BigFloat p(0, wp), q(0, wp);
+    mpf_set_z(p.get_mpf_t(), P.get_mpz_t());
+    mpf_set_z(q.get_mpf_t(), Q.get_mpz_t());
+    mpf_div(p.get_mpf_t(), p.get_mpf_t(), q.get_mpf_t());
+    mpf_add_ui(rop, p.get_mpf_t(), 1);
+}
+
+// ===== Constant cache =====
+
+const mpf_class& math_constant(MathConstant which, mp_bitcnt_t prec) {
+    // One table per constant, keyed by precision. Entries are never changed or
+    // removed, which is what keeps the returned references valid.
+    static std::mutex mutex;
+    static std::map<mp_bitcnt_t, std::unique_ptr<BigFloat>> tables[4];
+
+    prec = (prec + 127) / 128 * 128;   // nearby precisions share an entry
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = tables[static_cast<int>(which)];
+    auto it = table.lower_bound(prec);
+    if (it != table.end()) return *it->second;
+
+    std::unique_ptr<BigFloat> v(new BigFloat(0, prec));
+    switch (which) {
+    case MathConstant::Pi:   compute_pi(v->get_mpf_t()); break;
+    case MathConstant::E:    compute_e(v->get_mpf_t()); break;
+    case MathConstant::Ln2:  compute_ln2(v->get_mpf_t()); break;
+    case MathConstant::Ln10: compute_ln10(v->get_mpf_t()); break;
+    }
+    return *table.emplace(prec, std::move(v)).first->second;
+}
+
+// ===== exp / log =====
+
+// rop = sum_{n<N} r^n / n! for a small |r|, with N chosen for wp bits.
+// Rectangular splitting: with the powers r..r^m at hand, each block of m
+// terms costs m cheap multiplications by small integers and a single full
+// multiplication by r^m, instead of one full multiplication per term.
+static void exp_series(mpf_t rop, const mpf_t r, mp_bitcnt_t wp) {
+    if (mpf_sgn(r) == 0) { mpf_set_ui(rop, 1); return; }
+
+    // number of terms: |r|^N / N! < 2^-wp
+    const double lr = static_cast<double>(exponent2(r));
+    unsigned long terms = 1;
+    for (double l = 0; l > -static_cast<double>(wp) - 2; ++terms)
+        l += lr - std::log2(static_cast<double>(terms));
+
+    unsigned long m = static_cast<unsigned long>(std::sqrt(static_cast<double>(terms))) + 1;
+    unsigned long blocks = (terms + m - 1) / m;
+
+    std::vector<BigFloat> pw(m + 1, BigFloat(0, wp));   // pw[j] = r^j
+    mpf_set_ui(pw[0].get_mpf_t(), 1);
+    mpf_set(pw[1].get_mpf_t(), r);
+    for (unsigned long j = 2; j <= m; ++j)
+        mpf_mul(pw[j].get_mpf_t(), pw[j - 1].get_mpf_t(), r);
+
+    // Block i holds terms i*m .. i*m+m-1. Going from the last block down:
+    //   acc = (sum_j w_j r^j + acc * r^m / (i*m + m)) / P
+    // where P = (i*m+1)...(i*m+m-1) and w_j = (i*m+j+1)...(i*m+m-1).
+    BigFloat acc(0, wp), part(0, wp), wf(0, 64);
+    mpz_class w;
+    for (unsigned long i = blocks; i-- > 0;) {
+        const unsigned long base = i * m;
+        if (i + 1 < blocks) {
+            mpf_mul(acc.get_mpf_t(), acc.get_mpf_t(), pw[m].get_mpf_t());
+            mpf_div_ui(acc.get_mpf_t(), acc.get_mpf_t(), base + m);
+        }
+        w = 1;
+        for (unsigned long j = m; j-- > 0;) {
+            wf.set_prec(mpz_sizeinbase(w.get_mpz_t(), 2) + 64);
+            mpf_set_z(wf.get_mpf_t(), w.get_mpz_t());
+            mpf_mul(part.get_mpf_t(), pw[j].get_mpf_t(), wf.get_mpf_t());
+            mpf_add(acc.get_mpf_t(), acc.get_mpf_t(), part.get_mpf_t());
+            if (j > 0) w *= base + j;
+        }
+        wf.set_prec(mpz_sizeinbase(w.get_mpz_t(), 2) + 64);
+        mpf_set_z(wf.get_mpf_t(), w.get_mpz_t());
+        mpf_div(acc.get_mpf_t(), acc.get_mpf_t(), wf.get_mpf_t());
+    }
+    mpf_set(rop, acc.get_mpf_t());
+}
+
+bool big_exp(mpf_t rop, const mpf_t x) {
+    if (mpf_sgn(x) == 0) { mpf_set_ui(rop, 1); return true; }
+
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+    const double xd = mpf_get_d(x);
+    if (std::fabs(xd) > 1e15) {             // 2^(1.4e15) is out of reach
+        if (xd > 0) return false;
+        mpf_set_ui(rop, 0);
+        return true;
+    }
+
+    // x = k ln2 + r with |r| <= ln2/2, then exp(r) = exp(r / 2^s)^(2^s).
+    // k is a long below, like mp_exp_t, and both are 32 bits on Windows
+    const int64_t k64 = std::llround(xd / 0.69314718055994530942);
+    if (k64 > LONG_MAX || k64 < -LONG_MAX) {
+        if (k64 > 0) return false;
+        mpf_set_ui(rop, 0);
+        return true;
+    }
+    const long k = static_cast<long>(k64);
+    const mp_bitcnt_t s = static_cast<mp_bitcnt_t>(std::sqrt(static_cast<double>(prec))) / 2 + 2;
+    const mp_bitcnt_t wp = prec + kGuard + s;
+    const mp_bitcnt_t kbits = bit_length(static_cast<unsigned long>(k < 0 ? -k : k));
+
+    BigFloat r(0, wp + kbits);
+    mpf_set(r.get_mpf_t(), x);
+    if (k != 0) {
+        BigFloat l2(0, wp + kbits);
+        mpf_set(l2.get_mpf_t(), math_constant(MathConstant::Ln2, wp + kbits).get_mpf_t());
+        if (k > 0) mpf_mul_ui(l2.get_mpf_t(), l2.get_mpf_t(), static_cast<unsigned long>(k));
+        else       mpf_mul_ui(l2.get_mpf_t(), l2.get_mpf_t(), static_cast<unsigned long>(-k));
+        if (k > 0) mpf_sub(r.get_mpf_t(), r.get_mpf_t(), l2.get_mpf_t());
+        else       mpf_add(r.get_mpf_t(), r.get_mpf_t(), l2.get_mpf_t());
+    }
+    mpf_div_2exp(r.get_mpf_t(), r.get_mpf_t(), s);
+
+    BigFloat sum(0, wp);
+    exp_series(sum.get_mpf_t(), r.get_mpf_t(), wp);
+    for (mp_bitcnt_t i = 0; i < s; ++i)
+        mpf_mul(sum.get_mpf_t(), sum.get_mpf_t(), sum.get_mpf_t());
+
+    mul_2exp_si(rop, sum.get_mpf_t(), k);
+    return true;
+}
+
+// ln x = pi / (2 AGM(1, 4/y)) - m ln2 with y = x 2^m > 2^(wp/2)
+bool big_log(mpf_t rop, const mpf_t x) {
+    if (mpf_sgn(x) <= 0) return false;
+    if (mpf_cmp_ui(x, 1) == 0) { mpf_set_ui(rop, 0); return true; }
+
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+
+    // The two terms nearly cancel when x is close to 1: carry the bits lost
+    BigFloat d(0, mpf_get_prec(x) + 64);
+    mpf_sub_ui(d.get_mpf_t(), x, 1);
+    long ed = exponent2(d.get_mpf_t());
+    mp_bitcnt_t extra = ed < 0 ? static_cast<mp_bitcnt_t>(-ed) : 0;
+    const mp_bitcnt_t wp = prec + kGuard + extra + bit_length(prec);
+
+    const long m = static_cast<long>(wp / 2) + 2 - exponent2(x);
+    const mp_bitcnt_t mbits = bit_length(static_cast<unsigned long>(m < 0 ? -m : m));
+
+    BigFloat a(1, wp), b(0, wp), t(0, wp);
+    mpf_set(t.get_mpf_t(), x);
+    mul_2exp_si(t.get_mpf_t(), t.get_mpf_t(), m);
+    mpf_ui_div(b.get_mpf_t(), 4, t.get_mpf_t());
+
+    for (;;) {
+        mpf_add(t.get_mpf_t(), a.get_mpf_t(), b.get_mpf_t());
+        mpf_div_2exp(t.get_mpf_t(), t.get_mpf_t(), 1);
+        mpf_mul(b.get_mpf_t(), a.get_mpf_t(), b.get_mpf_t());
+        mpf_sqrt(b.get_mpf_t(), b.get_mpf_t());
+        mpf_swap(a.get_mpf_t(), t.get_mpf_t());
+
+        mpf_sub(t.get_mpf_t(), a.get_mpf_t(), b.get_mpf_t());
+        if (mpf_sgn(t.get_mpf_t()) == 0 || exponent2(t.get_mpf_t()) < exponent2(a.get_mpf_t()) - static_cast<long>(wp)) break;
+    }
+
+    BigFloat pi(0, wp), l2(0, wp + mbits);
+    mpf_set(pi.get_mpf_t(), math_constant(MathConstant::Pi, wp).get_mpf_t());
+    mpf_mul_2exp(a.get_mpf_t(), a.get_mpf_t(), 1);
+    mpf_div(pi.get_mpf_t(), pi.get_mpf_t(), a.get_mpf_t());
+    if (m != 0) {
+        mpf_set(l2.get_mpf_t(), math_constant(MathConstant::Ln2, wp + mbits).get_mpf_t());
+        if (m > 0) {
+            mpf_mul_ui(l2.get_mpf_t(), l2.get_mpf_t(), static_cast<unsigned long>(m));
+            mpf_sub(pi.get_mpf_t(), pi.get_mpf_t(), l2.get_mpf_t());
+        }
+        else {
+            mpf_mul_ui(l2.get_mpf_t(), l2.get_mpf_t(), static_cast<unsigned long>(-m));
+            mpf_add(pi.get_mpf_t(), pi.get_mpf_t(), l2.get_mpf_t());
+        }
+    }
+    mpf_set(rop, pi.get_mpf_t());
+    return true;
+}
+
+// rop = exp(y * ln|x|) for x != 0
+static bool pow_via_log(mpf_t rop, const mpf_t x, const mpf_t y) {
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+
+    // exp amplifies the absolute error of y ln x by |y ln x|
+    double l = std::fabs(mpf_get_d(y)) * std::fabs(static_cast<double>(exponent2(x)) + 1.0);
+    mp_bitcnt_t extra = l > 1.0 ? static_cast<mp_bitcnt_t>(std::log2(l)) + 2 : 0;
+    const mp_bitcnt_t wp = prec + kGuard + extra;
+
+    BigFloat ax(0, wp), lx(0, wp);
+    mpf_abs(ax.get_mpf_t(), x);
+    big_log(lx.get_mpf_t(), ax.get_mpf_t());
+    mpf_mul(lx.get_mpf_t(), lx.get_mpf_t(), y);
+
+    BigFloat r(0, prec + kGuard);
+    if (!big_exp(r.get_mpf_t(), lx.get_mpf_t())) return false;
+    mpf_set(rop, r.get_mpf_t());
+    return true;
+}
+
+bool big_pow(mpf_t rop, const mpf_t x, const mpf_t y) {
+    int sx = mpf_sgn(x);
+    if (sx == 0) {
+        if (mpf_sgn(y) <= 0) return false;
+        mpf_set_ui(rop, 0);
+        return true;
+    }
+    if (mpf_sgn(y) == 0) { mpf_set_ui(rop, 1); return true; }
+
+    if (sx > 0) return pow_via_log(rop, x, y);
+
+    // negative base: only integer exponents are real
+    if (!mpf_integer_p(y)) return false;
+    bool odd = false;
+    long n = 0;
+    if (fits_long_integer(y, n)) odd = (n & 1) != 0;
+    else {
+        mpz_class z;
+        mpz_set_f(z.get_mpz_t(), y);
+        odd = mpz_odd_p(z.get_mpz_t()) != 0;
+    }
+    if (!pow_via_log(rop, x, y)) return false;
+    if (odd) mpf_neg(rop, rop);
+    return true;
+}
+
+bool big_exp10(mpf_t rop, const mpf_t x) {
+    long n = 0;
+    if (fits_long_integer(x, n) && n >= 0) {
+        // exact: 10^n needs about 2.33 n bits for the odd part
+        mpz_class z;
+        mpz_ui_pow_ui(z.get_mpz_t(), 10, static_cast<unsigned long>(n));
+        mpf_set_z(rop, z.get_mpz_t());
+        return true;
+    }
+
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+    double l = std::fabs(mpf_get_d(x)) * 2.302585092994046;
+    mp_bitcnt_t extra = l > 1.0 ? static_cast<mp_bitcnt_t>(std::log2(l)) + 2 : 0;
+    BigFloat ln10(0, prec + kGuard + extra);
+    mpf_set(ln10.get_mpf_t(), math_constant(MathConstant::Ln10, ln10.get_prec()).get_mpf_t());
+    mpf_mul(ln10.get_mpf_t(), ln10.get_mpf_t(), x);
+    return big_exp(rop, ln10.get_mpf_t());
+}
+
+bool big_log10(mpf_t rop, const mpf_t x) {
+    const mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    BigFloat l(0, wp), ln10(0, wp);
+    if (!big_log(l.get_mpf_t(), x)) return false;
+    mpf_set(ln10.get_mpf_t(), math_constant(MathConstant::Ln10, ln10.get_prec()).get_mpf_t());
+    mpf_div(rop, l.get_mpf_t(), ln10.get_mpf_t());
+    return true;
+}
+
+// ===== Hyperbolic functions =====
+
+// e = exp(x), ei = exp(-x) = 1/e, with enough bits that e - ei keeps the
+// precision of the destination even for tiny x
+static bool exp_pair(BigFloat& e, BigFloat& ei, const mpf_t x, mp_bitcnt_t prec) {
+    long ex = exponent2(x);
+    mp_bitcnt_t extra = (ex < 0) ? static_cast<mp_bitcnt_t>(-ex) + 1 : 0;
+    mp_bitcnt_t wp = prec + kGuard + extra;
+    e.set_prec(wp);
+    ei.set_prec(wp);
+    if (!big_exp(e.get_mpf_t(), x)) return false;
+    mpf_ui_div(ei.get_mpf_t(), 1, e.get_mpf_t());
+    return true;
+}
+
+bool big_sinh_cosh(mpf_t s, mpf_t c, const mpf_t x) {
+    if (mpf_sgn(x) == 0) { mpf_set_ui(s, 0); mpf_set_ui(c, 1); return true; }
+    mp_bitcnt_t prec = mpf_get_prec(s) > mpf_get_prec(c) ? mpf_get_prec(s) : mpf_get_prec(c);
+
+    BigFloat e, ei;
+    if (mpf_sgn(x) > 0) { if (!exp_pair(e, ei, x, prec)) return false; }
+    else {
+        // exp(|x|) so a huge negative x overflows the same way as a positive one
+        BigFloat ax(0, mpf_get_prec(x));
+        mpf_abs(ax.get_mpf_t(), x);
+        if (!exp_pair(ei, e, ax.get_mpf_t(), prec)) return false;
+    }
+    BigFloat ts(0, e.get_prec()), tc(0, e.get_prec());
+    mpf_sub(ts.get_mpf_t(), e.get_mpf_t(), ei.get_mpf_t());
+    mpf_add(tc.get_mpf_t(), e.get_mpf_t(), ei.get_mpf_t());
+    mpf_div_2exp(s, ts.get_mpf_t(), 1);
+    mpf_div_2exp(c, tc.get_mpf_t(), 1);
+    return true;
+}
+
+bool big_sinh(mpf_t rop, const mpf_t x) {
+    BigFloat c(0, mpf_get_prec(rop));
+    return big_sinh_cosh(rop, c.get_mpf_t(), x);
+}
+
+bool big_cosh(mpf_t rop, const mpf_t x) {
+    BigFloat s(0, mpf_get_prec(rop));
+    return big_sinh_cosh(s.get_mpf_t(), rop, x);
+}
+
+void big_tanh(mpf_t rop, const mpf_t x) {
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+    // |tanh x| rounds to 1 once exp(-2|x|) is below the precision
+    if (std::fabs(mpf_get_d(x)) > 0.35 * static_cast<double>(prec + kGuard) + 1.0) {
+        mpf_set_si(rop, mpf_sgn(x));
+        return;
+    }
+    BigFloat s(0, prec + kGuard), c(0, prec + kGuard);
+    big_sinh_cosh(s.get_mpf_t(), c.get_mpf_t(), x);
+    mpf_div(rop, s.get_mpf_t(), c.get_mpf_t());
+}
+
+// Precision for the argument of a log whose result is about as small as t
+static mp_bitcnt_t log_arg_prec(mp_bitcnt_t prec, const mpf_t t) {
+    long e = exponent2(t);
+    return prec + kGuard + ((e < 0 && e != LONG_MIN) ? static_cast<mp_bitcnt_t>(-e) : 0);
+}
+
+bool big_asinh(mpf_t rop, const mpf_t x) {
+    // asinh x = sign(x) ln(|x| + sqrt(x^2 + 1))
+    const int sign = mpf_sgn(x);
+    if (sign == 0) { mpf_set_ui(rop, 0); return true; }
+    const mp_bitcnt_t wp = log_arg_prec(mpf_get_prec(rop), x);
+    BigFloat ax(0, wp), t(0, wp);
+    mpf_abs(ax.get_mpf_t(), x);
+    mpf_mul(t.get_mpf_t(), ax.get_mpf_t(), ax.get_mpf_t());
+    mpf_add_ui(t.get_mpf_t(), t.get_mpf_t(), 1);
+    mpf_sqrt(t.get_mpf_t(), t.get_mpf_t());
+    mpf_add(t.get_mpf_t(), t.get_mpf_t(), ax.get_mpf_t());
+    big_log(rop, t.get_mpf_t());
+    if (sign < 0) mpf_neg(rop, rop);
+    return true;
+}
+
+bool big_acosh(mpf_t rop, const mpf_t x) {
+    // acosh x = ln(x + sqrt((x - 1)(x + 1)))
+    if (mpf_cmp_ui(x, 1) < 0) return false;
+    if (mpf_cmp_ui(x, 1) == 0) { mpf_set_ui(rop, 0); return true; }
+    BigFloat xm1(0, mpf_get_prec(x) + 64);
+    mpf_sub_ui(xm1.get_mpf_t(), x, 1);
+    const mp_bitcnt_t wp = log_arg_prec(mpf_get_prec(rop), xm1.get_mpf_t());
+    BigFloat t(0, wp), xp1(0, wp);
+    mpf_add_ui(xp1.get_mpf_t(), x, 1);
+    mpf_mul(t.get_mpf_t(), xm1.get_mpf_t(), xp1.get_mpf_t());
+    mpf_sqrt(t.get_mpf_t(), t.get_mpf_t());
+    mpf_add(t.get_mpf_t(), t.get_mpf_t(), x);
+    big_log(rop, t.get_mpf_t());
+    return true;
+}
+
+bool big_atanh(mpf_t rop, const mpf_t x) {
+    // atanh x = ln((1 + x) / (1 - x)) / 2
+    if (mpf_cmp_si(x, -1) <= 0 || mpf_cmp_ui(x, 1) >= 0) return false;
+    if (mpf_sgn(x) == 0) { mpf_set_ui(rop, 0); return true; }
+    const mp_bitcnt_t wp = log_arg_prec(mpf_get_prec(rop), x) + 1;
+    BigFloat num(0, wp), den(0, wp);
+    mpf_add_ui(num.get_mpf_t(), x, 1);
+    mpf_ui_sub(den.get_mpf_t(), 1, x);
+    mpf_div(num.get_mpf_t(), num.get_mpf_t(), den.get_mpf_t());
+    big_log(rop, num.get_mpf_t());
+    mpf_div_2exp(rop, rop, 1);
+    return true;
+}
+
+// ===== Trigonometric functions =====
+
+// (s, c) = (sin, cos) of theta + q quarter turns, given s0, c0 of theta
+static void rotate_quadrant(mpf_t s, mpf_t c, const mpf_t s0, const mpf_t c0, unsigned long q) {
+    switch (q & 3) {
+    case 0: mpf_set(s, s0); mpf_set(c, c0); break;
+    case 1: mpf_set(s, c0); mpf_neg(c, s0); break;
+    case 2: mpf_neg(s, s0); mpf_neg(c, c0); break;
+    default: mpf_neg(s, c0); mpf_set(c, s0); break;
+    }
+}
+
+// sin and cos of |r| <= pi/4 + epsilon: Taylor series for sin(r / 2^h), cos
+// from sqrt(1 - sin^2), then h double-angle steps
+static void sin_cos_small(BigFloat& s, BigFloat& c, const mpf_t r, mp_bitcnt_t prec) {
+    if (mpf_sgn(r) == 0) { s = 0; c = 1; return; }
+
+    long er = exponent2(r);
+    long h = static_cast<long>(std::sqrt(static_cast<double>(prec)) / 2) + er;
+    if (h < 0) h = 0;
+    const mp_bitcnt_t wp = prec + kGuard + 2 * static_cast<mp_bitcnt_t>(h);
+    s.set_prec(wp);
+    c.set_prec(wp);
+
+    BigFloat t(0, wp), t2(0, wp), term(0, wp);
+    mpf_div_2exp(t.get_mpf_t(), r, static_cast<mp_bitcnt_t>(h));
+    mpf_mul(t2.get_mpf_t(), t.get_mpf_t(), t.get_mpf_t());
+    mpf_neg(t2.get_mpf_t(), t2.get_mpf_t());
+
+    // sin t = t - t^3/3! + t^5/5! - ...
+    mpf_set(s.get_mpf_t(), t.get_mpf_t());
+    mpf_set(term.get_mpf_t(), t.get_mpf_t());
+    const long stop = exponent2(t.get_mpf_t()) - static_cast<long>(wp);
+    for (unsigned long n = 1; ; ++n) {
+        mpf_mul(term.get_mpf_t(), term.get_mpf_t(), t2.get_mpf_t());
+        mpf_div_ui(term.get_mpf_t(), term.get_mpf_t(), (2 * n) * (2 * n + 1));
+        if (mpf_sgn(term.get_mpf_t()) == 0 || exponent2(term.get_mpf_t()) < stop) break;
+        mpf_add(s.get_mpf_t(), s.get_mpf_t(), term.get_mpf_t());
+    }
+    // cos t = sqrt(1 - sin^2 t), fine while t is well below pi/2
+    mpf_mul(c.get_mpf_t(), s.get_mpf_t(), s.get_mpf_t());
+    mpf_ui_sub(c.get_mpf_t(), 1, c.get_mpf_t());
+    mpf_sqrt(c.get_mpf_t(), c.get_mpf_t());
+
+    // sin 2t = 2 sin t cos t, cos 2t = 1 - 2 sin^2 t
+    for (long i = 0; i < h; ++i) {
+        mpf_mul(term.get_mpf_t(), s.get_mpf_t(), s.get_mpf_t());
+        mpf_mul(s.get_mpf_t(), s.get_mpf_t(), c.get_mpf_t());
+        mpf_mul_2exp(s.get_mpf_t(), s.get_mpf_t(), 1);
+        mpf_mul_2exp(term.get_mpf_t(), term.get_mpf_t(), 1);
+        mpf_ui_sub(c.get_mpf_t(), 1, term.get_mpf_t());
+    }
+}
+
+void big_sin_cos(mpf_t s, mpf_t c, const mpf_t x) {
+    const mp_bitcnt_t prec = mpf_get_prec(s) > mpf_get_prec(c) ? mpf_get_prec(s) : mpf_get_prec(c);
+    if (mpf_sgn(x) == 0) { mpf_set_ui(s, 0); mpf_set_ui(c, 1); return; }
+
+    // r = x - q pi/2. The absolute error of q pi/2 is about 2^(ex - rp), so
+    // rp must cover the magnitude of x plus whatever cancels in the subtraction.
+    const long ex = exponent2(x);
+    const mp_bitcnt_t wp = prec + kGuard;
+    mp_bitcnt_t rp = wp + (ex > 0 ? static_cast<mp_bitcnt_t>(ex) : 0) + 8;
+    BigFloat r, half_pi, qf;
+    mpz_class q;
+    for (;;) {
+        r.set_prec(rp);
+        half_pi.set_prec(rp);
+        qf.set_prec(rp);
+        mpf_set(half_pi.get_mpf_t(), math_constant(MathConstant::Pi, rp).get_mpf_t());
+        mpf_div_2exp(half_pi.get_mpf_t(), half_pi.get_mpf_t(), 1);
+
+        mpf_div(qf.get_mpf_t(), x, half_pi.get_mpf_t());
+        BigFloat half(0.5, 64);
+        mpf_add(qf.get_mpf_t(), qf.get_mpf_t(), half.get_mpf_t());
+        mpf_floor(qf.get_mpf_t(), qf.get_mpf_t());
+        mpz_set_f(q.get_mpz_t(), qf.get_mpf_t());
+
+        mpf_mul(qf.get_mpf_t(), qf.get_mpf_t(), half_pi.get_mpf_t());
+        mpf_sub(r.get_mpf_t(), x, qf.get_mpf_t());
+        if (mpf_sgn(r.get_mpf_t()) == 0) break;   // x was exactly q pi/2 at rp bits
+
+        long lost = ex - exponent2(r.get_mpf_t());
+        if (lost <= 0 || rp >= wp + static_cast<mp_bitcnt_t>(lost)) break;
+        rp = wp + static_cast<mp_bitcnt_t>(lost) + 16;
+    }
+
+    BigFloat s0, c0;
+    sin_cos_small(s0, c0, r.get_mpf_t(), prec);
+    rotate_quadrant(s, c, s0.get_mpf_t(), c0.get_mpf_t(), mpz_fdiv_ui(q.get_mpz_t(), 4));
+}
+
+void big_sin_cos_turn(mpf_t s, mpf_t c, const mpf_t x, unsigned long turn) {
+    const mp_bitcnt_t prec = mpf_get_prec(s) > mpf_get_prec(c) ? mpf_get_prec(s) : mpf_get_prec(c);
+    const unsigned long quarter = turn / 4;   // turn is 360 or 400, both divisible by 4
+
+    // Exact reduction: r = x - q quarter with q = round(x / quarter). x and
+    // q quarter are both exact, so r is exact given enough bits.
+    const long ex = exponent2(x);
+    const mp_bitcnt_t rp = mpf_get_prec(x) + 64 + (ex > 0 ? static_cast<mp_bitcnt_t>(ex) : 0);
+    BigFloat qf(0, rp), r(0, rp);
+    BigFloat half(0.5, 64);
+    mpf_div_ui(qf.get_mpf_t(), x, quarter);
+    mpf_add(qf.get_mpf_t(), qf.get_mpf_t(), half.get_mpf_t());
+    mpf_floor(qf.get_mpf_t(), qf.get_mpf_t());
+    mpz_class q;
+    mpz_set_f(q.get_mpz_t(), qf.get_mpf_t());
+    mpf_mul_ui(qf.get_mpf_t(), qf.get_mpf_t(), quarter);
+    mpf_sub(r.get_mpf_t(), x, qf.get_mpf_t());
+    const unsigned long quadrant = mpz_fdiv_ui(q.get_mpz_t(), 4);
+
+    BigFloat s0(0, prec + kGuard), c0(0, prec + kGuard);
+
+    // Table for r = 0, ±30 and ±45 degrees (±50 gradians)
+    if (mpf_integer_p(r.get_mpf_t()) && mpf_fits_slong_p(r.get_mpf_t())) {
+        long v = mpf_get_si(r.get_mpf_t());
+        unsigned long av = static_cast<unsigned long>(v < 0 ? -v : v);
+        bool special = true;
+        if (av == 0) { s0 = 0; c0 = 1; }
+        else if ((12 * av) % turn == 0) {          // 30 degrees
+            s0 = 0.5;
+            mpf_sqrt_ui(c0.get_mpf_t(), 3);
+            mpf_div_2exp(c0.get_mpf_t(), c0.get_mpf_t(), 1);
+        }
+        else if ((8 * av) % turn == 0) {           // 45 degrees
+            mpf_sqrt_ui(s0.get_mpf_t(), 2);
+            mpf_div_2exp(s0.get_mpf_t(), s0.get_mpf_t(), 1);
+            c0 = s0;
+        }
+        else special = false;
+        if (special) {
+            if (v < 0) mpf_neg(s0.get_mpf_t(), s0.get_mpf_t());
+            rotate_quadrant(s, c, s0.get_mpf_t(), c0.get_mpf_t(), quadrant);
+            return;
+        }
+    }
+
+    // |r| <= turn/8: convert to radians without any further reduction
+    BigFloat rad(0, prec + kGuard);
+    mpf_set(rad.get_mpf_t(), math_constant(MathConstant::Pi, prec + kGuard).get_mpf_t());
+    mpf_mul(rad.get_mpf_t(), rad.get_mpf_t(), r.get_mpf_t());
+    mpf_div_ui(rad.get_mpf_t(), rad.get_mpf_t(), 2 * quarter);   // 2 pi r / turn
+    sin_cos_small(s0, c0, rad.get_mpf_t(), prec);
+    rotate_quadrant(s, c, s0.get_mpf_t(), c0.get_mpf_t(), quadrant);
+}
+
+void big_atan(mpf_t rop, const mpf_t x) {
+    const int sign = mpf_sgn(x);
+    if (sign == 0) { mpf_set_ui(rop, 0); return; }
+    const mp_bitcnt_t prec = mpf_get_prec(rop);
+
+    // atan x = pi/2 - atan(1/x) for |x| > 1
+    long h = static_cast<long>(std::sqrt(static_cast<double>(prec)) / 2);
+    const mp_bitcnt_t wp = prec + kGuard + static_cast<mp_bitcnt_t>(h);
+    BigFloat y(0, wp), t(0, wp);
+    mpf_abs(y.get_mpf_t(), x);
+    const bool invert = mpf_cmp_ui(y.get_mpf_t(), 1) > 0;
+    if (invert) mpf_ui_div(y.get_mpf_t(), 1, y.get_mpf_t());
+
+    // atan y = 2 atan(y / (1 + sqrt(1 + y^2))), until y < 2^-h
+    unsigned long k = 0;
+    while (mpf_sgn(y.get_mpf_t()) != 0 && exponent2(y.get_mpf_t()) > -h) {
+        mpf_mul(t.get_mpf_t(), y.get_mpf_t(), y.get_mpf_t());
+        mpf_add_ui(t.get_mpf_t(), t.get_mpf_t(), 1);
+        mpf_sqrt(t.get_mpf_t(), t.get_mpf_t());
+        mpf_add_ui(t.get_mpf_t(), t.get_mpf_t(), 1);
+        mpf_div(y.get_mpf_t(), y.get_mpf_t(), t.get_mpf_t());
+        ++k;
+    }
+
+    // atan y = y - y^3/3 + y^5/5 - ...
+    BigFloat sum(0, wp), pw(0, wp), y2(0, wp);
+    mpf_set(sum.get_mpf_t(), y.get_mpf_t());
+    mpf_set(pw.get_mpf_t(), y.get_mpf_t());
+    mpf_mul(y2.get_mpf_t(), y.get_mpf_t(), y.get_mpf_t());
+    mpf_neg(y2.get_mpf_t(), y2.get_mpf_t());
+    const long stop = exponent2(y.get_mpf_t()) - static_cast<long>(wp);
+    for (unsigned long n = 1; ; ++n) {
+        mpf_mul(pw.get_mpf_t(), pw.get_mpf_t(), y2.get_mpf_t());
+        mpf_div_ui(t.get_mpf_t(), pw.get_mpf_t(), 2 * n + 1);
+        if (mpf_sgn(t.get_mpf_t()) == 0 || exponent2(t.get_mpf_t()) < stop) break;
+        mpf_add(sum.get_mpf_t(), sum.get_mpf_t(), t.get_mpf_t());
+    }
+    mpf_mul_2exp(sum.get_mpf_t(), sum.get_mpf_t(), k);
+
+    if (invert) {
+        mpf_set(t.get_mpf_t(), math_constant(MathConstant::Pi, wp).get_mpf_t());
+        mpf_div_2exp(t.get_mpf_t(), t.get_mpf_t(), 1);
+        mpf_sub(sum.get_mpf_t(), t.get_mpf_t(), sum.get_mpf_t());
+    }
+    if (sign < 0) mpf_neg(sum.get_mpf_t(), sum.get_mpf_t());
+    mpf_set(rop, sum.get_mpf_t());
+}
+
+// Sign of |x| - 1
+static int cmpabs_one(const mpf_t x) {
+    return mpf_sgn(x) >= 0 ? mpf_cmp_ui(x, 1) : -mpf_cmp_si(x, -1);
+}
+
+bool big_asin(mpf_t rop, const mpf_t x) {
+    // asin x = atan(x / sqrt((1 - x)(1 + x)))
+    int one = cmpabs_one(x);
+    if (one > 0) return false;
+    const mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    if (one == 0) {
+        int sign = mpf_sgn(x);
+        mpf_set(rop, math_constant(MathConstant::Pi, wp).get_mpf_t());
+        mpf_div_2exp(rop, rop, 1);
+        if (sign < 0) mpf_neg(rop, rop);
+        return true;
+    }
+    BigFloat a(0, wp), b(0, wp);
+    mpf_ui_sub(a.get_mpf_t(), 1, x);
+    mpf_add_ui(b.get_mpf_t(), x, 1);
+    mpf_mul(a.get_mpf_t(), a.get_mpf_t(), b.get_mpf_t());
+    mpf_sqrt(a.get_mpf_t(), a.get_mpf_t());
+    mpf_div(a.get_mpf_t(), x, a.get_mpf_t());
+    big_atan(rop, a.get_mpf_t());
+    return true;
+}
+
+bool big_acos(mpf_t rop, const mpf_t x) {
+    // acos x = 2 atan(sqrt((1 - x) / (1 + x))), which stays accurate near x = 1
+    if (cmpabs_one(x) > 0) return false;
+    const mp_bitcnt_t wp = mpf_get_prec(rop) + kGuard;
+    if (mpf_cmp_si(x, -1) == 0) { mpf_set(rop, math_constant(MathConstant::Pi, wp).get_mpf_t()); return true; }
+    BigFloat a(0, wp), b(0, wp);
+    mpf_ui_sub(a.get_mpf_t(), 1, x);
+    mpf_add_ui(b.get_mpf_t(), x, 1);
+    mpf_div(a.get_mpf_t(), a.get_mpf_t(), b.get_mpf_t());
+    mpf_sqrt(a.get_mpf_t(), a.get_mpf_t());
+    big_atan(rop, a.get_mpf_t());
+    mpf_mul_2exp(rop, rop, 1);
+    return true;
+}
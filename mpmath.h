@@ -0,0 +1,67 @@
+#ifndef MPMATH_H
+#define MPMATH_H
+
+// Multiprecision elementary functions on GMP mpf_t values.
+//
+// Every function works to the precision of its destination operand
+// (mpf_get_prec(rop)) and carries guard bits internally, so the result is
+// good to about that many bits. Destinations may alias sources.
+// Functions returning bool return false when the argument is outside the
+// domain (or the result cannot be represented); rop is left untouched then.
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Constants, computed from scratch at the precision of rop
+void compute_pi(mpf_t rop);     // Chudnovsky series, binary splitting
+void compute_e(mpf_t rop);      // sum of 1/k!, binary splitting
+void compute_ln2(mpf_t rop);    // binary splitting of atanh series
+void compute_ln10(mpf_t rop);   // 3 ln2 + 2 atanh(1/9)
+
+enum class MathConstant { Pi, E, Ln2, Ln10 };
+
+// Shared constant cache. The first request at a given precision computes the
+// constant; later requests at that or any lower precision get the stored
+// value back. The reference stays valid for the life of the process and
+// holds at least `prec` bits. Safe to call from several threads.
+const mpf_class& math_constant(MathConstant which, mp_bitcnt_t prec);
+
+// exp by ln2 argument reduction, halving and Taylor series; false when |x| is
+// too large for the result to be stored (exp of a large negative x gives 0)
+bool big_exp(mpf_t rop, const mpf_t x);
+
+// Natural logarithm through the arithmetic-geometric mean; x > 0
+bool big_log(mpf_t rop, const mpf_t x);
+
+// x^y = exp(y ln x). A negative base needs an integer exponent; 0^y needs y > 0
+bool big_pow(mpf_t rop, const mpf_t x, const mpf_t y);
+
+bool big_exp10(mpf_t rop, const mpf_t x);   // exact for integer x >= 0
+bool big_log10(mpf_t rop, const mpf_t x);
+
+// Hyperbolic functions, sharing a single exp(x) per call
+bool big_sinh_cosh(mpf_t s, mpf_t c, const mpf_t x);
+bool big_sinh(mpf_t rop, const mpf_t x);
+bool big_cosh(mpf_t rop, const mpf_t x);
+void big_tanh(mpf_t rop, const mpf_t x);
+
+bool big_asinh(mpf_t rop, const mpf_t x);
+bool big_acosh(mpf_t rop, const mpf_t x);   // x >= 1
+bool big_atanh(mpf_t rop, const mpf_t x);   // |x| < 1
+
+// Trigonometric functions of an angle in radians. sin and cos are always
+// computed together after reducing x by a multiple of pi/2.
+void big_sin_cos(mpf_t s, mpf_t c, const mpf_t x);
+
+// sin and cos of an angle measured in units of 1/turn of a full turn (360 for
+// degrees, 400 for gradians). x is first reduced exactly modulo `turn`, so
+// sin(1e30 deg) is as accurate as sin(10 deg). Multiples of 30 and 45
+// degrees come from a table: sin(30 deg) is exactly 0.5, cos(90 deg) exactly 0.
+void big_sin_cos_turn(mpf_t s, mpf_t c, const mpf_t x, unsigned long turn);
+
+// Inverse functions, results in radians
+void big_atan(mpf_t rop, const mpf_t x);
+bool big_asin(mpf_t rop, const mpf_t x);   // |x| <= 1
+bool big_acos(mpf_t rop, const mpf_t x);   // |x| <= 1
+
+#endif // MPMATH_H
@@ -0,0 +1,172 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace trace {
+
+#ifdef NUMERIC_ENGINE_TRACE
+
+namespace {
+
+struct Event {
+    int stage;
+    int tid;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+const size_t kMaxEvents = 65536;
+
+struct Session {
+    std::mutex mutex;
+    std::vector<StageStats> stages;
+    std::vector<CounterStats> counters;
+    std::vector<Event> ring;   // the most recent kMaxEvents scopes
+    size_t next = 0;           // where the next event goes once the ring is full
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Session& session() {
+    static Session s;
+    return s;
+}
+
+// Small per-thread number for the trace viewer's rows
+int thread_id() {
+    static std::atomic<int> next_id{ 1 };
+    thread_local int id = next_id++;
+    return id;
+}
+
+// Names come from string literals at the call sites; escaping covers quotes
+// and backslashes only
+void write_json_string(FILE* f, const std::string& s) {
+    std::fputc('"', f);
+    for (char c : s) {
+        if (c == '"' || c == '\\') std::fputc('\\', f);
+        std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+// Call sites sharing a name share the entry
+int stage(const char* name) {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (size_t i = 0; i < s.stages.size(); ++i)
+        if (s.stages[i].name == name) return static_cast<int>(i);
+    s.stages.push_back(StageStats());
+    s.stages.back().name = name;
+    return static_cast<int>(s.stages.size() - 1);
+}
+
+int counter(const char* name) {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (size_t i = 0; i < s.counters.size(); ++i)
+        if (s.counters[i].name == name) return static_cast<int>(i);
+    s.counters.push_back(CounterStats());
+    s.counters.back().name = name;
+    return static_cast<int>(s.counters.size() - 1);
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - session().epoch).count());
+}
+
+void record(int stage, uint64_t start_ns, uint64_t end_ns) {
+    Event e = { stage, thread_id(), start_ns, end_ns };
+    uint64_t dur = end_ns - start_ns;
+
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    StageStats& st = s.stages[static_cast<size_t>(stage)];
+    ++st.calls;
+    st.total_ns += dur;
+    if (dur > st.max_ns) st.max_ns = dur;
+
+    if (s.ring.size() < kMaxEvents) {
+        if (s.ring.empty()) s.ring.reserve(kMaxEvents);
+        s.ring.push_back(e);
+    }
+    else {
+        s.ring[s.next] = e;
+        s.next = (s.next + 1) % kMaxEvents;
+    }
+}
+
+void count(int counter, long long n) {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.counters[static_cast<size_t>(counter)].value += n;
+}
+
+std::vector<StageStats> stage_stats() {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.stages;
+}
+
+std::vector<CounterStats> counter_stats() {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.counters;
+}
+
+void reset() {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (StageStats& st : s.stages) st.calls = st.total_ns = st.max_ns = 0;
+    for (CounterStats& c : s.counters) c.value = 0;
+    s.ring.clear();
+    s.next = 0;
+}
+
+bool write_chrome_trace(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    uint64_t last_ns = 0;
+    for (size_t i = 0; i < s.ring.size(); ++i) {
+        const Event& e = s.ring[(s.next + i) % s.ring.size()];   // oldest first
+        std::fprintf(f, "  {\"name\": ");
+        write_json_string(f, s.stages[static_cast<size_t>(e.stage)].name);
+        std::fprintf(f, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f},\n",
+            e.tid, e.start_ns / 1000.0, (e.end_ns - e.start_ns) / 1000.0);
+        if (e.end_ns > last_ns) last_ns = e.end_ns;
+    }
+    // counters as one sample each at the end of the trace
+    for (const CounterStats& c : s.counters) {
+        std::fprintf(f, "  {\"name\": ");
+        write_json_string(f, c.name);
+        std::fprintf(f, ", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, \"args\": {\"value\": %lld}},\n",
+            last_ns / 1000.0, c.value);
+    }
+    std::fprintf(f, "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"numeric-engine\"}}\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+#else // tracing compiled out: nothing is recorded
+
+int stage(const char*) { return 0; }
+int counter(const char*) { return 0; }
+uint64_t now_ns() { return 0; }
+void record(int, uint64_t, uint64_t) {}
+void count(int, long long) {}
+std::vector<StageStats> stage_stats() { return {}; }
+std::vector<CounterStats> counter_stats() { return {}; }
+void reset() {}
+bool write_chrome_trace(const std::string&) { return false; }
+
+#endif
+
+} // namespace trace
@@ -0,0 +1,86 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Hot-path instrumentation: scoped stage timers and counters.
+//
+//   TRACE_SCOPE("parse");          // times the rest of the enclosing block
+//   TRACE_COUNT("cache hits", 1);  // adds to a named counter
+//
+// The macros only do something when the tree is configured with
+// -DNUMERIC_ENGINE_TRACE=ON; otherwise they expand to nothing and the
+// functions below report no data. Every timed scope updates per-stage totals
+// and is also kept as an event in a ring of the most recent 65536, which
+// write_chrome_trace() saves in the Chrome / Perfetto trace-event format.
+// Safe to use from several threads.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+#ifdef NUMERIC_ENGINE_TRACE
+constexpr bool compiled_in = true;
+#else
+constexpr bool compiled_in = false;
+#endif
+
+struct StageStats {
+    std::string name;
+    unsigned long long calls = 0;
+    unsigned long long total_ns = 0;
+    unsigned long long max_ns = 0;
+};
+
+struct CounterStats {
+    std::string name;
+    long long value = 0;
+};
+
+// Ids for the macros; each call site registers its name once
+int stage(const char* name);
+int counter(const char* name);
+
+uint64_t now_ns();   // steady clock, from the start of the session
+void record(int stage, uint64_t start_ns, uint64_t end_ns);
+void count(int counter, long long n);
+
+// Totals since the start of the session or the last reset(), in the order
+// the names were first used
+std::vector<StageStats> stage_stats();
+std::vector<CounterStats> counter_stats();
+void reset();
+
+// Trace-event JSON for chrome://tracing or ui.perfetto.dev; false when the
+// file cannot be written or tracing is not compiled in
+bool write_chrome_trace(const std::string& path);
+
+class Scope {
+public:
+    explicit Scope(int stage) : id(stage), start(now_ns()) {}
+    ~Scope() { record(id, start, now_ns()); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    int id;
+    uint64_t start;
+};
+
+} // namespace trace
+
+#ifdef NUMERIC_ENGINE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    static const int TRACE_CONCAT(trace_stage_, __LINE__) = ::trace::stage(name); \
+    ::trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(TRACE_CONCAT(trace_stage_, __LINE__))
+#define TRACE_COUNT(name, n) \
+    do { static const int trace_counter_ = ::trace::counter(name); ::trace::count(trace_counter_, (n)); } while (0)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_COUNT(name, n) ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,208 @@
+#include "units.h"
+
+#include <cstring>
+
+// ===== Tables =====
+// Factors are exact by definition: the international yard and pound, US
+// customary volumes from the gallon of 231 in³, the Julian year, the
+// thermochemical calorie, the IT BTU and the 2019 SI value of the electron
+// volt.
+
+namespace {
+
+constexpr Unit kLength[] = {
+    { "m", "metre", { 1 } },
+    { "nm", "nanometre", { 1, 1, -9 } },
+    { "µm", "micrometre", { 1, 1, -6 } },
+    { "mm", "millimetre", { 1, 1, -3 } },
+    { "cm", "centimetre", { 1, 1, -2 } },
+    { "km", "kilometre", { 1, 1, 3 } },
+    { "in", "inch", { 254, 1, -4 } },
+    { "ft", "foot", { 3048, 1, -4 } },
+    { "yd", "yard", { 9144, 1, -4 } },
+    { "mi", "mile", { 1609344, 1, -3 } },
+    { "nmi", "nautical mile", { 1852 } },
+    { "au", "astronomical unit", { 149597870700 } },
+    { "ly", "light-year", { 9460730472580800 } },
+};
+
+constexpr Unit kArea[] = {
+    { "m²", "square metre", { 1 } },
+    { "mm²", "square millimetre", { 1, 1, -6 } },
+    { "cm²", "square centimetre", { 1, 1, -4 } },
+    { "ha", "hectare", { 1, 1, 4 } },
+    { "km²", "square kilometre", { 1, 1, 6 } },
+    { "in²", "square inch", { 64516, 1, -8 } },
+    { "ft²", "square foot", { 9290304, 1, -8 } },
+    { "yd²", "square yard", { 83612736, 1, -8 } },
+    { "ac", "acre", { 40468564224, 1, -7 } },
+    { "mi²", "square mile", { 2589988110336, 1, -6 } },
+};
+
+constexpr Unit kVolume[] = {
+    { "m³", "cubic metre", { 1 } },
+    { "mL", "millilitre", { 1, 1, -6 } },
+    { "L", "litre", { 1, 1, -3 } },
+    { "tsp", "teaspoon (US)", { 492892159375, 1, -17 } },
+    { "tbsp", "tablespoon (US)", { 1478676478125, 1, -17 } },
+    { "fl oz", "fluid ounce (US)", { 295735295625, 1, -16 } },
+    { "cup", "cup (US)", { 2365882365, 1, -13 } },
+    { "pt", "pint (US)", { 473176473, 1, -12 } },
+    { "qt", "quart (US)", { 946352946, 1, -12 } },
+    { "gal", "gallon (US)", { 3785411784, 1, -12 } },
+    { "imp gal", "gallon (imperial)", { 454609, 1, -8 } },
+    { "in³", "cubic inch", { 16387064, 1, -12 } },
+    { "ft³", "cubic foot", { 28316846592, 1, -12 } },
+};
+
+constexpr Unit kMass[] = {
+    { "kg", "kilogram", { 1 } },
+    { "mg", "milligram", { 1, 1, -6 } },
+    { "g", "gram", { 1, 1, -3 } },
+    { "t", "tonne", { 1, 1, 3 } },
+    { "oz", "ounce", { 28349523125, 1, -12 } },
+    { "lb", "pound", { 45359237, 1, -8 } },
+    { "st", "stone", { 635029318, 1, -8 } },
+    { "sh tn", "short ton", { 90718474, 1, -5 } },
+    { "long tn", "long ton", { 10160469088, 1, -7 } },
+};
+
+constexpr Unit kTime[] = {
+    { "s", "second", { 1 } },
+    { "ns", "nanosecond", { 1, 1, -9 } },
+    { "µs", "microsecond", { 1, 1, -6 } },
+    { "ms", "millisecond", { 1, 1, -3 } },
+    { "min", "minute", { 60 } },
+    { "h", "hour", { 3600 } },
+    { "d", "day", { 86400 } },
+    { "wk", "week", { 604800 } },
+    { "yr", "year (Julian)", { 31557600 } },
+};
+
+// K = °C + 273.15 = (°F + 459.67) × 5/9 = °R × 5/9
+constexpr Unit kTemperature[] = {
+    { "K", "kelvin", { 1 } },
+    { "°C", "degree Celsius", { 1 }, { 27315, 1, -2 } },
+    { "°F", "degree Fahrenheit", { 5, 9 }, { 45967, 180 } },
+    { "°R", "degree Rankine", { 5, 9 } },
+};
+
+constexpr Unit kSpeed[] = {
+    { "m/s", "metre per second", { 1 } },
+    { "km/h", "kilometre per hour", { 5, 18 } },
+    { "mph", "mile per hour", { 1609344, 3600, -3 } },
+    { "kn", "knot", { 1852, 3600 } },
+    { "ft/s", "foot per second", { 3048, 1, -4 } },
+};
+
+constexpr Unit kDataSize[] = {
+    { "B", "byte", { 1 } },
+    { "bit", "bit", { 1, 8 } },
+    { "kB", "kilobyte", { 1, 1, 3 } },
+    { "MB", "megabyte", { 1, 1, 6 } },
+    { "GB", "gigabyte", { 1, 1, 9 } },
+    { "TB", "terabyte", { 1, 1, 12 } },
+    { "KiB", "kibibyte", { int64_t(1) << 10 } },
+    { "MiB", "mebibyte", { int64_t(1) << 20 } },
+    { "GiB", "gibibyte", { int64_t(1) << 30 } },
+    { "TiB", "tebibyte", { int64_t(1) << 40 } },
+};
+
+constexpr Unit kEnergy[] = {
+    { "J", "joule", { 1 } },
+    { "kJ", "kilojoule", { 1, 1, 3 } },
+    { "MJ", "megajoule", { 1, 1, 6 } },
+    { "cal", "calorie", { 4184, 1, -3 } },
+    { "kcal", "kilocalorie", { 4184 } },
+    { "Wh", "watt-hour", { 3600 } },
+    { "kWh", "kilowatt-hour", { 36, 1, 5 } },
+    { "eV", "electronvolt", { 1602176634, 1, -28 } },
+    { "BTU", "British thermal unit", { 105505585262, 1, -8 } },
+};
+
+// psi is one pound-force, 4.4482216152605 N, per square inch
+constexpr Unit kPressure[] = {
+    { "Pa", "pascal", { 1 } },
+    { "kPa", "kilopascal", { 1, 1, 3 } },
+    { "bar", "bar", { 1, 1, 5 } },
+    { "atm", "standard atmosphere", { 101325 } },
+    { "psi", "pound per square inch", { 44482216152605, 64516, -5 } },
+    { "mmHg", "millimetre of mercury", { 133322387415, 1, -9 } },
+    { "Torr", "torr", { 101325, 760 } },
+};
+
+template <size_t N>
+constexpr UnitCategory category(const char* name, const Unit (&units)[N]) {
+    return { name, units, N };
+}
+
+constexpr UnitCategory kCategories[] = {
+    category("Length", kLength),
+    category("Area", kArea),
+    category("Volume", kVolume),
+    category("Mass", kMass),
+    category("Time", kTime),
+    category("Temperature", kTemperature),
+    category("Speed", kSpeed),
+    category("Data size", kDataSize),
+    category("Energy", kEnergy),
+    category("Pressure", kPressure),
+};
+
+} // namespace
+
+const UnitCategory* unit_categories(size_t& count) {
+    count = sizeof(kCategories) / sizeof(kCategories[0]);
+    return kCategories;
+}
+
+const UnitCategory* find_unit_category(const std::string& name) {
+    for (const UnitCategory& c : kCategories)
+        if (name == c.name) return &c;
+    return nullptr;
+}
+
+const Unit* find_unit(const UnitCategory& category, const std::string& symbol) {
+    for (size_t i = 0; i < category.count; ++i) {
+        const Unit& u = category.units[i];
+        if (symbol == u.symbol || symbol == u.name) return &u;
+    }
+    return nullptr;
+}
+
+// ===== Conversion =====
+
+// An int64_t into an mpz without going through long, which is 32 bits on Windows
+static void setInt64(mpz_ptr z, int64_t v) {
+    uint64_t mag = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    mpz_import(z, 1, -1, sizeof(mag), 0, 0, &mag);
+    if (v < 0) mpz_neg(z, z);
+}
+
+static mpq_class toMpq(const UnitRatio& r) {
+    mpq_class q;
+    setInt64(q.get_num_mpz_t(), r.num);
+    setInt64(q.get_den_mpz_t(), r.den);
+    mpz_class p;
+    mpz_ui_pow_ui(p.get_mpz_t(), 10, static_cast<unsigned long>(r.exp10 < 0 ? -r.exp10 : r.exp10));
+    mpz_mul(r.exp10 < 0 ? q.get_den_mpz_t() : q.get_num_mpz_t(),
+        r.exp10 < 0 ? q.get_den_mpz_t() : q.get_num_mpz_t(), p.get_mpz_t());
+    q.canonicalize();
+    return q;
+}
+
+// from → base → to: x × ff + of = y × ft + ot
+UnitConversion::UnitConversion(const Unit& from, const Unit& to) {
+    mpq_class to_factor = toMpq(to.factor);
+    scale_q = toMpq(from.factor) / to_factor;
+    shift_q = (toMpq(from.offset) - toMpq(to.offset)) / to_factor;
+    scale_d = scale_q.get_d();
+    shift_d = shift_q.get_d();
+    affine = shift_q != 0;
+}
+
+mpq_class UnitConversion::apply(const mpq_class& x) const {
+    mpq_class y = x * scale_q;
+    if (affine) y += shift_q;
+    return y;
+}
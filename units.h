@@ -0,0 +1,66 @@
+#ifndef UNITS_H
+#define UNITS_H
+
+// Unit conversion for the Converter window and the command-line tools. Part
+// of the headless core like engine.h; nothing in here may depend on Qt.
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// num/den × 10^exp10, exactly: enough for every defined unit, including
+// 1.602176634e-19 J and 5/9 K, without floating point in the tables
+struct UnitRatio {
+    int64_t num;
+    int64_t den = 1;
+    int exp10 = 0;
+};
+
+// One unit of a category, pre-normalized to the category's base unit:
+// a quantity x of it is x × factor + offset base units. Only temperatures
+// have an offset.
+struct Unit {
+    const char* symbol;   // "ft"; unique within the category
+    const char* name;     // "foot"
+    UnitRatio factor;
+    UnitRatio offset = { 0 };
+};
+
+struct UnitCategory {
+    const char* name;   // "Length"
+    const Unit* units;  // units[0] is the base unit
+    size_t count;
+};
+
+// Every category, in the order the Converter lists them
+const UnitCategory* unit_categories(size_t& count);
+
+// A category by name, a unit by symbol or name; case-sensitive, nullptr
+// when there is none
+const UnitCategory* find_unit_category(const std::string& name);
+const Unit* find_unit(const UnitCategory& category, const std::string& symbol);
+
+// The conversion between two units of one category, folded into
+// y = x × scale + shift when it is made, so converting a value is one
+// multiplication and, for temperatures, one addition
+class UnitConversion
+{
+public:
+    UnitConversion(const Unit& from, const Unit& to);
+
+    mpq_class apply(const mpq_class& x) const;   // exact
+    double apply(double x) const { return affine ? x * scale_d + shift_d : x * scale_d; }
+
+    const mpq_class& scale() const { return scale_q; }
+    const mpq_class& shift() const { return shift_q; }
+
+private:
+    mpq_class scale_q, shift_q;
+    double scale_d, shift_d;   // the same as doubles, for bulk data
+    bool affine;               // shift != 0
+};
+
+#endif // UNITS_H
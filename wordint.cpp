@@ -0,0 +1,553 @@
+#include "wordint.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// ===== Bit primitives =====
+// GCC and Clang turn the shift-or idiom into a single rol/ror; MSVC gets its
+// intrinsics.
+
+template <class U>
+static U rotl(U x, unsigned n) {
+    const unsigned w = sizeof(U) * 8;
+    n &= w - 1;
+    return static_cast<U>((x << n) | (x >> ((w - n) & (w - 1))));
+}
+
+template <class U>
+static U rotr(U x, unsigned n) {
+    const unsigned w = sizeof(U) * 8;
+    n &= w - 1;
+    return static_cast<U>((x >> n) | (x << ((w - n) & (w - 1))));
+}
+
+#if defined(_MSC_VER)
+template <> uint8_t rotl(uint8_t x, unsigned n) { return _rotl8(x, static_cast<unsigned char>(n & 7)); }
+template <> uint16_t rotl(uint16_t x, unsigned n) { return _rotl16(x, static_cast<unsigned char>(n & 15)); }
+template <> uint32_t rotl(uint32_t x, unsigned n) { return _rotl(x, static_cast<int>(n & 31)); }
+template <> uint64_t rotl(uint64_t x, unsigned n) { return _rotl64(x, static_cast<int>(n & 63)); }
+template <> uint8_t rotr(uint8_t x, unsigned n) { return _rotr8(x, static_cast<unsigned char>(n & 7)); }
+template <> uint16_t rotr(uint16_t x, unsigned n) { return _rotr16(x, static_cast<unsigned char>(n & 15)); }
+template <> uint32_t rotr(uint32_t x, unsigned n) { return _rotr(x, static_cast<int>(n & 31)); }
+template <> uint64_t rotr(uint64_t x, unsigned n) { return _rotr64(x, static_cast<int>(n & 63)); }
+#endif
+
+static unsigned popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<unsigned>(__popcnt64(x));
+#else
+    unsigned n = 0;
+    for (; x; x &= x - 1) ++n;
+    return n;
+#endif
+}
+
+// Leading zeros of a 64-bit word; x != 0
+static unsigned clz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_clzll(x));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return 63u - static_cast<unsigned>(i);
+#else
+    unsigned n = 0;
+    for (uint64_t top = uint64_t(1) << 63; !(x & top); top >>= 1) ++n;
+    return n;
+#endif
+}
+
+static uint64_t widthMask(unsigned width) {
+    return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+// 64-bit words to and from mpz, whatever the size of a limb or of a long
+static void setU64(mpz_ptr z, uint64_t x) {
+    mpz_set_ui(z, static_cast<unsigned long>(x >> 32));
+    mpz_mul_2exp(z, z, 32);
+    mpz_add_ui(z, z, static_cast<unsigned long>(x & 0xffffffffu));
+}
+
+static uint64_t low64(mpz_srcptr z) {   // of |z|
+    uint64_t v = 0;
+    for (size_t i = 0, shift = 0; shift < 64 && i < mpz_size(z); ++i, shift += GMP_NUMB_BITS)
+        v |= static_cast<uint64_t>(mpz_getlimbn(z, i)) << shift;
+    return v;
+}
+
+// ===== Native words =====
+
+// a op b in U. Arithmetic goes through at least `unsigned`, so uint8_t and
+// uint16_t operands never promote to a signed int that could overflow.
+template <class U>
+static U nativeOp(WordOp op, U a, U b) {
+    typedef typename std::make_signed<U>::type S;
+    typedef typename std::conditional<(sizeof(U) < sizeof(unsigned)), unsigned, U>::type W;
+    const unsigned n = sizeof(U) * 8;
+    switch (op) {
+    case WordOp::Add: return static_cast<U>(W(a) + W(b));
+    case WordOp::Sub: return static_cast<U>(W(a) - W(b));
+    case WordOp::Mul: return static_cast<U>(W(a) * W(b));
+    case WordOp::Div:   // MIN / -1 wraps to MIN instead of trapping
+        if (static_cast<S>(b) == -1) return static_cast<U>(W(0) - W(a));
+        return static_cast<U>(static_cast<S>(a) / static_cast<S>(b));
+    case WordOp::Mod:
+        if (static_cast<S>(b) == -1) return 0;
+        return static_cast<U>(static_cast<S>(a) % static_cast<S>(b));
+    case WordOp::And: return static_cast<U>(a & b);
+    case WordOp::Or:  return static_cast<U>(a | b);
+    case WordOp::Xor: return static_cast<U>(a ^ b);
+    case WordOp::Shl: return b >= n ? U(0) : static_cast<U>(W(a) << b);
+    case WordOp::Shr:
+        if (b >= n) return static_cast<S>(a) < 0 ? static_cast<U>(~U(0)) : U(0);
+        return static_cast<U>(static_cast<S>(a) >> b);
+    case WordOp::Rol: return rotl(a, static_cast<unsigned>(b % n));
+    case WordOp::Ror: return rotr(a, static_cast<unsigned>(b % n));
+    }
+    return a;
+}
+
+static uint64_t nativeApply(unsigned width, WordOp op, uint64_t a, uint64_t b) {
+    switch (width) {
+    case 8:  return nativeOp<uint8_t>(op, static_cast<uint8_t>(a), static_cast<uint8_t>(b));
+    case 16: return nativeOp<uint16_t>(op, static_cast<uint16_t>(a), static_cast<uint16_t>(b));
+    case 32: return nativeOp<uint32_t>(op, static_cast<uint32_t>(a), static_cast<uint32_t>(b));
+    default: return nativeOp<uint64_t>(op, a, b);
+    }
+}
+
+// ===== WordInt =====
+
+WordInt::WordInt(unsigned width, uint64_t pattern) : bits(width) {
+    if (native()) w = pattern & widthMask(width);
+    else if (pattern != 0) setU64(big.get_mpz_t(), pattern);
+}
+
+WordInt WordInt::fromMpz(unsigned width, const mpz_class& x) {
+    WordInt r(width);
+    if (r.native()) {
+        uint64_t v = low64(x.get_mpz_t());
+        r.w = (mpz_sgn(x.get_mpz_t()) < 0 ? ~v + 1 : v) & widthMask(width);
+    }
+    else mpz_fdiv_r_2exp(r.big.get_mpz_t(), x.get_mpz_t(), width);
+    return r;
+}
+
+static int digitValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return 99;
+}
+
+bool WordInt::parse(unsigned width, const std::string& digits, int radix, WordInt& out) {
+    if (digits.empty() || radix < 2 || radix > 36) return false;
+    WordInt r(width);
+    if (r.native()) {
+        // wrapping modulo 2^64 first is wrapping modulo 2^width too
+        uint64_t v = 0;
+        for (char c : digits) {
+            int d = digitValue(c);
+            if (d >= radix) return false;
+            v = v * static_cast<uint64_t>(radix) + static_cast<uint64_t>(d);
+        }
+        r.w = v & widthMask(width);
+    }
+    else {
+        for (char c : digits)
+            if (digitValue(c) >= radix) return false;
+        mpz_set_str(r.big.get_mpz_t(), digits.c_str(), radix);
+        mpz_fdiv_r_2exp(r.big.get_mpz_t(), r.big.get_mpz_t(), width);
+    }
+    out = std::move(r);
+    return true;
+}
+
+uint64_t WordInt::word() const {
+    return native() ? w : low64(big.get_mpz_t());
+}
+
+mpz_class WordInt::toMpz(bool is_signed) const {
+    mpz_class v;
+    if (native()) {
+        bool neg = is_signed && negative();
+        setU64(v.get_mpz_t(), neg ? (~w + 1) & widthMask(bits) : w);   // the magnitude
+        if (neg) mpz_neg(v.get_mpz_t(), v.get_mpz_t());
+        return v;
+    }
+    v = big;
+    if (is_signed && negative()) {
+        mpz_class top;
+        mpz_setbit(top.get_mpz_t(), bits);
+        v -= top;
+    }
+    return v;
+}
+
+bool WordInt::negative() const {
+    return native() ? ((w >> (bits - 1)) & 1) != 0 : mpz_tstbit(big.get_mpz_t(), bits - 1) != 0;
+}
+
+bool WordInt::isZero() const {
+    return native() ? w == 0 : mpz_sgn(big.get_mpz_t()) == 0;
+}
+
+WordInt WordInt::resized(unsigned width) const {
+    if (native() && width <= 64) {
+        uint64_t x = w;
+        if (negative()) x |= ~widthMask(bits);   // sign-extend to 64 bits, then cut
+        return WordInt(width, x);
+    }
+    return fromMpz(width, toMpz(true));
+}
+
+unsigned WordInt::popcount() const {
+    return native() ? popcount64(w) : static_cast<unsigned>(mpz_popcount(big.get_mpz_t()));
+}
+
+unsigned WordInt::leadingZeros() const {
+    if (isZero()) return bits;
+    if (native()) return clz64(w) - (64 - bits);
+    return bits - static_cast<unsigned>(mpz_sizeinbase(big.get_mpz_t(), 2));
+}
+
+// ===== Rendering =====
+
+namespace {
+
+struct DigitTables {
+    char hex[256][2];   // a byte as two hex digits
+    char bin[256][8];   // a byte as eight binary digits
+    char oct[64][2];    // six bits as two octal digits
+
+    DigitTables() {
+        static const char kHex[] = "0123456789ABCDEF";
+        for (unsigned b = 0; b < 256; ++b) {
+            hex[b][0] = kHex[b >> 4];
+            hex[b][1] = kHex[b & 15];
+            for (unsigned i = 0; i < 8; ++i) bin[b][i] = static_cast<char>('0' + ((b >> (7 - i)) & 1));
+        }
+        for (unsigned b = 0; b < 64; ++b) {
+            oct[b][0] = static_cast<char>('0' + (b >> 3));
+            oct[b][1] = static_cast<char>('0' + (b & 7));
+        }
+    }
+};
+
+const DigitTables& digitTables() {
+    static const DigitTables tables;
+    return tables;
+}
+
+} // namespace
+
+// The digits of n little-endian limbs, `group` bits per lookup of `per`
+// digits, written right to left with one pass over the limbs; a group that
+// straddles two limbs is finished from the next one
+template <unsigned group, unsigned per>
+static std::string tableDigits(const mp_limb_t* limbs, size_t n, const char (*table)[per]) {
+    const mp_limb_t mask = (mp_limb_t(1) << group) - 1;
+    std::string s(((n * GMP_NUMB_BITS + group - 1) / group) * per, '0');
+    char* p = &s[0] + s.size();
+    mp_limb_t carry = 0;   // low bits of a group begun in the previous limb
+    unsigned have = 0;
+    for (size_t i = 0; i < n; ++i) {
+        mp_limb_t limb = limbs[i];
+        unsigned left = GMP_NUMB_BITS;
+        if (have != 0) {
+            p -= per;
+            std::memcpy(p, table[(carry | (limb << have)) & mask], per);
+            limb >>= group - have;
+            left -= group - have;
+        }
+        for (; left >= group; left -= group, limb >>= group) {
+            p -= per;
+            std::memcpy(p, table[limb & mask], per);
+        }
+        carry = limb;
+        have = left;
+    }
+    if (have != 0) {
+        p -= per;
+        std::memcpy(p, table[carry], per);
+    }
+    s.erase(0, std::min(s.find_first_not_of('0'), s.size() - 1));
+    return s;
+}
+
+// The digits of n limbs in radix 2^log2radix (1, 3 or 4), without leading zeros
+static std::string powerOfTwoDigits(const mp_limb_t* limbs, size_t n, unsigned log2radix) {
+    while (n > 0 && limbs[n - 1] == 0) --n;
+    if (n == 0) return "0";
+    const DigitTables& t = digitTables();
+    if (log2radix == 4) return tableDigits<8, 2>(limbs, n, t.hex);
+    if (log2radix == 3) return tableDigits<6, 2>(limbs, n, t.oct);
+    return tableDigits<8, 8>(limbs, n, t.bin);
+}
+
+std::string WordInt::toString(int radix, bool is_signed) const {
+    static const char kDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const bool neg = is_signed && negative();
+    const unsigned log2radix = radix == 16 ? 4 : radix == 8 ? 3 : radix == 2 ? 1 : 0;
+    if (!native()) {
+        mpz_class magnitude;
+        mpz_srcptr v = big.get_mpz_t();
+        if (neg) {
+            magnitude = -toMpz(true);
+            v = magnitude.get_mpz_t();
+        }
+        std::string s;
+        if (log2radix) s = powerOfTwoDigits(mpz_limbs_read(v), mpz_size(v), log2radix);
+        else {
+            s.resize(mpz_sizeinbase(v, radix) + 1);
+            mpz_get_str(&s[0], -radix, v);   // upper case; sizeinbase may be one over
+            s.resize(std::strlen(s.c_str()));
+        }
+        return neg ? "-" + s : s;
+    }
+
+    uint64_t x = neg ? (~w + 1) & widthMask(bits) : w;
+    if (log2radix) {
+        mp_limb_t limbs[64 / GMP_NUMB_BITS + 1];
+        size_t n = 0;
+        for (unsigned shift = 0; shift < 64; shift += GMP_NUMB_BITS) limbs[n++] = static_cast<mp_limb_t>(x >> shift);
+        std::string s = powerOfTwoDigits(limbs, n, log2radix);
+        return neg ? "-" + s : s;
+    }
+    char buf[65];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = kDigits[x % static_cast<uint64_t>(radix)];
+        x /= static_cast<uint64_t>(radix);
+    } while (x != 0);
+    if (neg) *--p = '-';
+    return std::string(p, buf + sizeof(buf));
+}
+
+// ===== Operations =====
+
+// Shift or rotation count from b: its pattern as an unsigned number, capped
+// at `cap` so every count of cap or more behaves alike
+static unsigned long shiftCount(const WordInt& b, unsigned long cap) {
+    if (b.native()) return b.word() < cap ? static_cast<unsigned long>(b.word()) : cap;
+    mpz_class v = b.toMpz(false);
+    return mpz_cmp_ui(v.get_mpz_t(), cap) < 0 ? mpz_get_ui(v.get_mpz_t()) : cap;
+}
+
+bool word_apply(WordOp op, const WordInt& a, const WordInt& b, WordInt& out) {
+    const unsigned width = a.width();
+    if (b.width() != width) return word_apply(op, a, b.resized(width), out);
+    if ((op == WordOp::Div || op == WordOp::Mod) && b.isZero()) return false;
+
+    if (a.native()) {   // in place: no mpz_class is made or freed
+        out.bits = width;
+        out.w = nativeApply(width, op, a.w, b.w);
+        return true;
+    }
+
+    mpz_class r;
+    mpz_ptr rp = r.get_mpz_t();
+    switch (op) {
+    case WordOp::Add: r = a.toMpz(false) + b.toMpz(false); break;
+    case WordOp::Sub: r = a.toMpz(false) - b.toMpz(false); break;
+    case WordOp::Mul: r = a.toMpz(false) * b.toMpz(false); break;
+    case WordOp::Div: mpz_tdiv_q(rp, a.toMpz(true).get_mpz_t(), b.toMpz(true).get_mpz_t()); break;
+    case WordOp::Mod: mpz_tdiv_r(rp, a.toMpz(true).get_mpz_t(), b.toMpz(true).get_mpz_t()); break;
+    case WordOp::And: r = a.toMpz(false) & b.toMpz(false); break;
+    case WordOp::Or:  r = a.toMpz(false) | b.toMpz(false); break;
+    case WordOp::Xor: r = a.toMpz(false) ^ b.toMpz(false); break;
+    case WordOp::Shl: {
+        unsigned long k = shiftCount(b, width);
+        if (k < width) mpz_mul_2exp(rp, a.toMpz(false).get_mpz_t(), k);
+        break;
+    }
+    case WordOp::Shr:   // floor division by 2^k is the arithmetic shift
+        mpz_fdiv_q_2exp(rp, a.toMpz(true).get_mpz_t(), shiftCount(b, width));
+        break;
+    case WordOp::Rol:
+    case WordOp::Ror: {
+        mpz_class count = b.toMpz(false);
+        unsigned long k = mpz_fdiv_ui(count.get_mpz_t(), width);
+        if (op == WordOp::Ror) k = (width - k) % width;
+        mpz_class x = a.toMpz(false), hi;
+        mpz_mul_2exp(rp, x.get_mpz_t(), k);
+        mpz_fdiv_q_2exp(hi.get_mpz_t(), x.get_mpz_t(), width - k);
+        mpz_ior(rp, rp, hi.get_mpz_t());
+        break;
+    }
+    }
+    out = WordInt::fromMpz(width, r);
+    return true;
+}
+
+WordInt word_not(const WordInt& a) {
+    if (a.native()) return WordInt(a.width(), ~a.word());
+    mpz_class r;
+    mpz_com(r.get_mpz_t(), a.toMpz(false).get_mpz_t());
+    return WordInt::fromMpz(a.width(), r);
+}
+
+WordInt word_neg(const WordInt& a) {
+    if (a.native()) return WordInt(a.width(), ~a.word() + 1);
+    return WordInt::fromMpz(a.width(), -a.toMpz(false));
+}
+
+// ===== Expression evaluator =====
+// Recursive descent over the same tokens the float Parser reads. Words are
+// cheap to copy, so values are returned directly instead of building a tree.
+
+namespace {
+
+class WordParser {
+public:
+    WordParser(const Token* first, const Token* last, const WordOptions& o)
+        : t(first), end(last), opts(o) {}
+
+    WordInt parse() {
+        WordInt v = orExpr();
+        if (t != end) fail();
+        return v;
+    }
+
+    bool div0 = false;   // a division or mod by zero happened; it gave 0
+
+private:
+    static const int kMaxNesting = 1000;   // as in the float Parser
+
+    struct Nest {
+        WordParser& p;
+        explicit Nest(WordParser& parser) : p(parser) { if (++p.nesting > kMaxNesting) fail(); }
+        ~Nest() { --p.nesting; }
+    };
+
+    [[noreturn]] static void fail() { throw std::invalid_argument("syntax"); }
+
+    bool atOperator(char c) const { return t != end && t->isOperator(c); }
+
+    WordInt binary(WordOp op, const WordInt& a, const WordInt& b) {
+        WordInt r(opts.width);
+        if (!word_apply(op, a, b, r)) div0 = true;
+        return r;
+    }
+
+    WordInt orExpr() {
+        WordInt lhs = xorExpr();
+        while (atOperator('|')) { ++t; lhs = binary(WordOp::Or, lhs, xorExpr()); }
+        return lhs;
+    }
+
+    WordInt xorExpr() {
+        WordInt lhs = andExpr();
+        while (atOperator('x')) { ++t; lhs = binary(WordOp::Xor, lhs, andExpr()); }
+        return lhs;
+    }
+
+    WordInt andExpr() {
+        WordInt lhs = shiftExpr();
+        while (atOperator('&')) { ++t; lhs = binary(WordOp::And, lhs, shiftExpr()); }
+        return lhs;
+    }
+
+    WordInt shiftExpr() {
+        WordInt lhs = sum();
+        while (atOperator('<') || atOperator('>')) {
+            WordOp op = ((t++)->op == '<') ? WordOp::Shl : WordOp::Shr;
+            lhs = binary(op, lhs, sum());
+        }
+        return lhs;
+    }
+
+    WordInt sum() {
+        WordInt lhs = term();
+        while (atOperator('+') || atOperator('-')) {
+            WordOp op = ((t++)->op == '+') ? WordOp::Add : WordOp::Sub;
+            lhs = binary(op, lhs, term());
+        }
+        return lhs;
+    }
+
+    WordInt term() {
+        WordInt lhs = unary();
+        for (;;) {
+            WordOp op;
+            if (atOperator('*')) op = WordOp::Mul;
+            else if (atOperator('/')) op = WordOp::Div;
+            else if (atOperator('%')) op = WordOp::Mod;
+            else return lhs;
+            ++t;
+            lhs = binary(op, lhs, unary());
+        }
+    }
+
+    WordInt unary() {
+        if (!atOperator('-') && !atOperator('~')) return primary();
+        bool complement = (t++)->op == '~';
+        Nest nest(*this);
+        WordInt arg = unary();
+        return complement ? word_not(arg) : word_neg(arg);
+    }
+
+    WordInt primary() {
+        if (t == end) fail();
+        switch (t->kind) {
+        case TokenKind::Number: {
+            // split entries ("1", "F") are one literal, as in the float Parser
+            std::string digits = (t++)->text;
+            while (t != end && t->kind == TokenKind::Number) digits += (t++)->text;
+            WordInt v(opts.width);
+            if (!WordInt::parse(opts.width, digits, opts.radix, v)) fail();
+            return v;
+        }
+        case TokenKind::Ans:
+            ++t;
+            return opts.ans.width() == opts.width ? opts.ans : opts.ans.resized(opts.width);
+        case TokenKind::LParen: {
+            ++t;
+            Nest nest(*this);
+            WordInt inner = orExpr();
+            if (t != end && t->kind == TokenKind::RParen) ++t;
+            else fail();
+            return inner;
+        }
+        default:
+            fail();
+        }
+    }
+
+    const Token* t;
+    const Token* end;
+    const WordOptions& opts;
+    int nesting = 0;
+};
+
+} // namespace
+
+WordResult evaluate_words(const std::vector<Token>& tokens, const WordOptions& opts) {
+    TRACE_SCOPE("words");
+    WordResult r;
+    r.value = WordInt(opts.width);
+    WordParser parser(tokens.data(), tokens.data() + tokens.size(), opts);
+    try {
+        r.value = parser.parse();
+    }
+    catch (const std::invalid_argument&) {
+        r.status = EvalStatus::SyntaxError;
+        r.error = "Error: syntax";
+        r.value = WordInt(opts.width);
+        return r;
+    }
+    if (parser.div0) {
+        r.status = EvalStatus::DivideByZero;
+        r.error = "undefined";
+    }
+    return r;
+}
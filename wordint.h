@@ -0,0 +1,102 @@
+#ifndef WORDINT_H
+#define WORDINT_H
+
+// Fixed-width integer arithmetic for the Programmer view. Part of the
+// headless core like engine.h; nothing in here may depend on Qt.
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine.h"   // Token, EvalStatus
+
+// Word lengths offered by the Programmer view, in bits
+enum class WordLength : unsigned {
+    Byte = 8,
+    Word = 16,
+    DWord = 32,
+    QWord = 64
+};
+
+enum class WordOp { Add, Sub, Mul, Div, Mod, And, Or, Xor, Shl, Shr, Rol, Ror };
+
+// A two's-complement integer of a fixed width: 8, 16, 32, 64 or any number
+// of bits above 64. Up to 64 bits the value is one machine word and every
+// operation runs on the uintN_t of that width, so results wrap around by
+// themselves; wider values are held in an mpz_class kept in [0, 2^width).
+class WordInt
+{
+public:
+    explicit WordInt(unsigned width = 64, uint64_t bits = 0);
+
+    // x modulo 2^width: negative x come out in two's complement
+    static WordInt fromMpz(unsigned width, const mpz_class& x);
+
+    // Digits in `radix` (2..36, either case) wrapped to the width, as a
+    // pasted bit string of any length is; false on any other character
+    static bool parse(unsigned width, const std::string& digits, int radix, WordInt& out);
+
+    unsigned width() const { return bits; }
+    bool native() const { return bits <= 64; }
+    uint64_t word() const;                    // the low 64 bits
+    mpz_class toMpz(bool is_signed) const;    // the bit pattern, or its signed value
+    bool negative() const;                    // sign bit set
+    bool isZero() const;
+
+    // The same signed value at another width: truncated when narrower,
+    // sign-extended when wider
+    WordInt resized(unsigned width) const;
+
+    unsigned popcount() const;
+    unsigned leadingZeros() const;   // width() for 0
+
+    bool operator==(const WordInt& o) const { return bits == o.bits && (native() ? w == o.w : big == o.big); }
+    bool operator!=(const WordInt& o) const { return !(*this == o); }
+
+    // The bit pattern in `radix` with upper-case digits; with is_signed a
+    // negative value is written as '-' and its magnitude. Every radix is
+    // read off the binary value itself: hex, octal and binary through lookup
+    // tables a byte or six bits at a time, decimal by mpz_get_str's divide
+    // and conquer once the value is wider than a machine word.
+    std::string toString(int radix, bool is_signed = false) const;
+
+private:
+    friend bool word_apply(WordOp op, const WordInt& a, const WordInt& b, WordInt& out);
+
+    unsigned bits;
+    uint64_t w = 0;    // native widths, zero-extended
+    mpz_class big;     // wider ones
+};
+
+// out = a op b at the width of a (b is taken at that width too). Div and Mod
+// are signed and truncate toward zero, Shr is an arithmetic shift, and a
+// shift by width() bits or more leaves 0 or the sign; rotations count modulo
+// width(). False for Div or Mod by 0, leaving out untouched.
+bool word_apply(WordOp op, const WordInt& a, const WordInt& b, WordInt& out);
+WordInt word_not(const WordInt& a);
+WordInt word_neg(const WordInt& a);
+
+struct WordOptions {
+    unsigned width = 64;
+    int radix = 10;   // of the Number tokens
+    WordInt ans;      // value of ANS, resized to `width`
+};
+
+struct WordResult {
+    EvalStatus status = EvalStatus::Ok;   // Ok, DivideByZero or SyntaxError
+    WordInt value;
+    std::string error;   // user-facing message when status != Ok
+
+    bool ok() const { return status == EvalStatus::Ok; }
+};
+
+// Evaluate the Programmer view's token stream in words of opts.width bits:
+// numbers, ANS, parentheses, + - * / mod, the bitwise AND OR XOR, the shifts
+// LSH RSH, unary minus and NOT. Loosest first the precedence is OR, XOR, AND,
+// shifts, + -, * / mod, then the unary operators, as in C.
+WordResult evaluate_words(const std::vector<Token>& tokens, const WordOptions& opts);
+
+#endif // WORDINT_H